@@ -0,0 +1,91 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace std::chrono;
+
+//! The original byte-at-a-time checksum, kept as a reference
+class ScalarChecksum {
+    uint32_t _sum{};
+    bool _parity{};
+
+  public:
+    void add(string_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint32_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+//! Checksum `reps` packets of `packet_size` bytes each
+//! \returns the throughput in GB/s
+template <typename ChecksumT>
+double measure(const string &data, const size_t packet_size, const size_t reps, uint16_t &result) {
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < reps; i++) {
+        ChecksumT check;
+        check.add(string_view(data).substr(0, packet_size));
+        result ^= check.value();
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return double(packet_size) * reps / double(duration);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        string data(65536, 0);
+        for (auto &ch : data) {
+            ch = rd();
+        }
+
+        // make sure both implementations agree, including on odd lengths and split inputs
+        for (size_t len = 0; len < 2048; len++) {
+            ScalarChecksum scalar;
+            scalar.add(string_view(data).substr(0, len));
+            InternetChecksum fast;
+            fast.add(string_view(data).substr(0, len / 3));
+            fast.add(string_view(data).substr(len / 3, len - len / 3));
+            if (scalar.value() != fast.value()) {
+                throw runtime_error("checksum mismatch for length " + to_string(len));
+            }
+        }
+
+        cout << "InternetChecksum kernel: " << InternetChecksum::implementation() << "\n";
+        cout << fixed << setprecision(2);
+        uint16_t sink = 0;
+        for (const size_t packet_size : {20, 64, 576, 1500, 9000, 65536}) {
+            const size_t reps = (size_t(1) << 30) / packet_size;
+            const double scalar = measure<ScalarChecksum>(data, packet_size, reps / 8, sink);
+            const double fast = measure<InternetChecksum>(data, packet_size, reps, sink);
+            cout << setw(6) << packet_size << " bytes:  scalar " << setw(6) << scalar << " GB/s,  "
+                 << InternetChecksum::implementation() << " " << setw(6) << fast << " GB/s  (" << fast / scalar
+                 << "x)\n";
+        }
+        cerr << "(ignore: " << sink << ")\n";
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
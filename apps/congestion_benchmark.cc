@@ -0,0 +1,125 @@
+#include "tcp_connection.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+static constexpr size_t TRANSFER_SIZE = 4 * 1024 * 1024;
+static constexpr uint64_t TIME_LIMIT_MS = 60000;
+
+//! \brief One direction of a simulated path: a drop-tail queue in front of a bottleneck of
+//! `rate` bytes per millisecond, then `delay` ms of propagation, with random loss on top
+class Link {
+  private:
+    size_t _rate;
+    uint64_t _delay;
+    size_t _queue_limit;
+    double _loss;
+    mt19937 &_rd;
+    deque<TCPSegment> _queue{};
+    size_t _credit = 0;
+    deque<pair<uint64_t, TCPSegment>> _propagating{};
+
+  public:
+    size_t drops = 0;
+
+    Link(const size_t rate, const uint64_t delay, const size_t queue_limit, const double loss, mt19937 &rd)
+        : _rate(rate), _delay(delay), _queue_limit(queue_limit), _loss(loss), _rd(rd) {}
+
+    //! Take every segment `from` has queued, dropping any that overflow the queue or are lost
+    void accept(TCPConnection &from) {
+        while (not from.segments_out().empty()) {
+            if (_queue.size() >= _queue_limit or uniform_real_distribution<double>{}(_rd) < _loss) {
+                drops++;
+            } else {
+                _queue.push_back(move(from.segments_out().front()));
+            }
+            from.segments_out().pop();
+        }
+    }
+
+    //! Serve the queue for the millisecond ending at `now`, then hand `to` whatever has arrived
+    void deliver(const uint64_t now, TCPConnection &to) {
+        _credit = _queue.empty() ? 0 : _credit + _rate;
+        while (not _queue.empty()) {
+            const size_t size = TCPHeader::LENGTH + _queue.front().payload().size();
+            if (size > _credit) {
+                break;
+            }
+            _credit -= size;
+            _propagating.emplace_back(now + _delay, move(_queue.front()));
+            _queue.pop_front();
+        }
+        while (not _propagating.empty() and _propagating.front().first <= now) {
+            to.segment_received(_propagating.front().second);
+            _propagating.pop_front();
+        }
+    }
+};
+
+//! \brief Send TRANSFER_SIZE bytes (or for TIME_LIMIT_MS, whichever comes first) over a path with a 1 MB/s
+//! bottleneck, 20 ms RTT, a 20-segment queue and random `loss`
+//! \param pacing_rate if set, pace the sender at this many bytes per ms (0: at its own estimate)
+static void transfer(const TCPConfig::Congestion algorithm,
+                     const string &name,
+                     const double loss,
+                     const optional<size_t> pacing_rate = {}) {
+    auto rd = get_random_generator();
+    TCPConfig config;
+    config.congestion_control = algorithm;
+    config.pacing = pacing_rate.has_value();
+    config.pacing_rate = pacing_rate.value_or(0);
+    TCPConnection sender{config}, receiver{config};
+    Link forward{1000, 10, 20, loss, rd}, reverse{1000000, 10, 1000, loss, rd};
+
+    const string chunk(TCPConfig::DEFAULT_CAPACITY, 'x');
+    size_t written = 0, received = 0;
+    uint64_t now = 0;
+    sender.connect();
+    while (received < TRANSFER_SIZE and now < TIME_LIMIT_MS) {
+        if (written < TRANSFER_SIZE) {
+            const size_t want = min(TRANSFER_SIZE - written, sender.remaining_outbound_capacity());
+            written += sender.write(chunk.substr(0, want));
+        }
+        forward.accept(sender);
+        reverse.accept(receiver);
+        now++;
+        forward.deliver(now, receiver);
+        reverse.deliver(now, sender);
+        received += receiver.inbound_stream().read(receiver.inbound_stream().buffer_size()).size();
+        sender.tick(1);
+        receiver.tick(1);
+    }
+
+    cout << setw(14) << name << ", " << loss * 100 << "% loss: " << setw(5) << received * 8.0 / now / 1000
+         << " Mbit/s (of 8), " << setw(5) << forward.drops << " segments dropped, " << setw(7) << received
+         << " bytes in " << setw(5) << double(now) / 1000 << " s\n";
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(2);
+        for (const double loss : {0.0, 0.001, 0.01}) {
+            transfer(TCPConfig::Congestion::None, "none", loss);
+            transfer(TCPConfig::Congestion::None, "none, 1 MB/s", loss, 1000);
+            transfer(TCPConfig::Congestion::NewReno, "NewReno", loss);
+            transfer(TCPConfig::Congestion::NewReno, "NewReno, paced", loss, 0);
+            transfer(TCPConfig::Congestion::Cubic, "CUBIC", loss);
+            transfer(TCPConfig::Congestion::Cubic, "CUBIC, paced", loss, 0);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
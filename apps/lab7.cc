@@ -106,10 +106,25 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
 
         return {};
     }
+    size_t read_batch(vector<TCPSegment> &segs, const size_t, const bool wait = true) {
+        if (not wait) {
+            return 0;
+        }
+        auto seg = read();
+        if (seg) {
+            segs.push_back(move(seg.value()));
+        }
+        return 1;
+    }
     void write(TCPSegment &seg) {
         _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
         send_pending();
     }
+    void write_batch(vector<TCPSegment> &segs) {
+        for (auto &seg : segs) {
+            write(seg);
+        }
+    }
     void tick(const size_t ms_since_last_tick) {
         _interface.tick(ms_since_last_tick);
         send_pending();
@@ -149,7 +149,7 @@ class Host {
 
 class Network {
   private:
-    Router _router{};
+    Router _router;
 
     size_t default_id, eth0_id, eth1_id, eth2_id, uun3_id, hs4_id, mit5_id;
 
@@ -205,8 +205,9 @@ class Network {
     }
 
   public:
-    Network()
-        : default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
+    explicit Network(const Router::Fib fib)
+        : _router(fib)
+        , default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
         , eth0_id(_router.add_interface({random_router_ethernet_address(), {"10.0.0.1"}}))
         , eth1_id(_router.add_interface({random_router_ethernet_address(), {"172.16.0.1"}}))
         , eth2_id(_router.add_interface({random_router_ethernet_address(), {"192.168.0.1"}}))
@@ -269,12 +270,12 @@ class Network {
     }
 };
 
-void network_simulator() {
+void network_simulator(const Router::Fib fib) {
     const string green = "\033[32;1m", normal = "\033[m";
 
     cerr << green << "Constructing network." << normal << "\n";
 
-    Network network;
+    Network network{fib};
 
     cout << green << "\n\nTesting traffic between two ordinary hosts (applesauce to cherrypie)..." << normal << "\n\n";
     {
@@ -343,9 +344,13 @@ void network_simulator() {
     cout << "\n\n\033[32;1mCongratulations! All datagrams were routed successfully.\033[m\n";
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     try {
-        network_simulator();
+        if (argc > 2 or (argc == 2 and string(argv[1]) != "dir24_8")) {
+            cerr << "Usage: " << argv[0] << " [dir24_8]\n";
+            return EXIT_FAILURE;
+        }
+        network_simulator(argc == 2 ? Router::Fib::Dir24_8 : Router::Fib::Trie);
     } catch (const exception &e) {
         cerr << "\n\n\n";
         cerr << "\033[31;1mError: " << e.what() << "\033[m\n";
@@ -0,0 +1,144 @@
+#include "dir24_8_table.hh"
+#include "prefix_trie.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t N_PREFIXES = 500000;
+static constexpr size_t N_LOOKUPS = 10000000;
+static constexpr size_t N_CHECKS = 2000;
+
+struct Route {
+    uint32_t prefix;
+    uint8_t length;
+    size_t interface_num;
+};
+
+static uint32_t mask(const uint8_t length) { return length == 0 ? 0 : ~uint32_t(0) << (32 - length); }
+
+//! The longest-prefix match found by scanning every route, as the original Router did
+static const Route *brute_force_lookup(const vector<Route> &routes, const uint32_t address) {
+    const Route *best = nullptr;
+    for (const auto &route : routes) {
+        if (((address ^ route.prefix) & mask(route.length)) == 0 and (not best or best->length <= route.length)) {
+            best = &route;
+        }
+    }
+    return best;
+}
+
+//! Compare `table` against a linear scan of `routes` on `n` random addresses
+template <typename Table>
+static void check(const Table &table, const vector<Route> &routes, mt19937 &rd, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t address = rd();
+        const Route *expected = brute_force_lookup(routes, address);
+        const size_t *actual = table.lookup(address);
+        if ((expected == nullptr) != (actual == nullptr) or (expected and *actual != expected->interface_num)) {
+            throw runtime_error("lookup mismatch for address " + to_string(address));
+        }
+    }
+}
+
+//! Load `routes` into a `Table`, check it, time lookups of `addresses`, then check it again after removing half
+template <typename Table>
+static void benchmark(const string &name,
+                      const vector<Route> &routes,
+                      const vector<uint32_t> &addresses,
+                      mt19937 &rd,
+                      size_t &sink) {
+    auto table = make_unique<Table>();
+    const auto load_start = steady_clock::now();
+    for (const auto &route : routes) {
+        table->insert(route.prefix, route.length, route.interface_num);
+    }
+    const auto load_duration = duration_cast<nanoseconds>(steady_clock::now() - load_start).count();
+    check(*table, routes, rd, N_CHECKS);
+
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+        const size_t *interface_num = table->lookup(addresses[i & (addresses.size() - 1)]);
+        sink += interface_num ? *interface_num : 0;
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    cout << name << ", " << table->size() << " prefixes: " << double(duration) / N_LOOKUPS << " ns/lookup ("
+         << N_LOOKUPS * 1e9 / double(duration) << " lookups/s), " << double(load_duration) / routes.size()
+         << " ns/insert, " << table->memory_usage() / 1048576.0 << " MiB\n";
+
+    // remove every other route and make sure lookups fall back to the covering prefixes
+    vector<Route> remaining;
+    for (size_t i = 0; i < routes.size(); i++) {
+        if (i % 2) {
+            if (not table->erase(routes[i].prefix, routes[i].length)) {
+                throw runtime_error(name + ": failed to erase route " + to_string(i));
+            }
+        } else {
+            remaining.push_back(routes[i]);
+        }
+    }
+    if (table->size() != remaining.size()) {
+        throw runtime_error(name + ": wrong size after erase");
+    }
+    check(*table, remaining, rd, N_CHECKS);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // a table shaped roughly like a full BGP table: mostly /24s, with shorter and a few longer prefixes
+        // (weights are for lengths /1 through /32)
+        discrete_distribution<int> length_dist{{0,  0,   0,   0,    0,    0,    0,    0,     1, 1, 1, 2, 5, 10, 20, 40,
+                                                60, 400, 800, 1500, 3500, 6000, 9000, 50000, 5, 5, 5, 5, 5, 5,  5,  5}};
+        vector<Route> routes;
+        routes.reserve(N_PREFIXES);
+        unordered_set<uint64_t> seen;
+        while (routes.size() < N_PREFIXES) {
+            const uint8_t length = 1 + length_dist(rd);
+            const uint32_t prefix = rd() & mask(length);
+            if (seen.insert(uint64_t(prefix) << 8 | length).second) {
+                routes.push_back({prefix, length, routes.size()});
+            }
+        }
+
+        vector<uint32_t> addresses(1 << 16);
+        for (auto &address : addresses) {
+            address = rd();
+        }
+        size_t sink = 0;
+
+        cout << fixed << setprecision(1);
+        benchmark<PrefixTrie<size_t>>("PrefixTrie", routes, addresses, rd, sink);
+        benchmark<Dir24_8Table<size_t>>("Dir24_8Table", routes, addresses, rd, sink);
+
+        // for comparison, the linear scan the Router used to do
+        const auto scan_start = steady_clock::now();
+        for (size_t i = 0; i < N_CHECKS; i++) {
+            const Route *route = brute_force_lookup(routes, addresses[i]);
+            sink += route ? route->interface_num : 0;
+        }
+        const auto scan_duration = duration_cast<nanoseconds>(steady_clock::now() - scan_start).count();
+        cout << "linear scan, " << routes.size() << " prefixes: " << double(scan_duration) / N_CHECKS
+             << " ns/lookup (" << N_CHECKS * 1e9 / double(scan_duration) << " lookups/s)\n";
+
+        cerr << "(ignore: " << sink << ")\n";
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
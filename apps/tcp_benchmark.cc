@@ -11,11 +11,26 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+void move_segments(TCPConnection &x,
+                   TCPConnection &y,
+                   vector<TCPSegment> &segments,
+                   const bool reorder,
+                   const bool gro = false) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        // cut super-segments into MSS-sized pieces, as an adapter would
+        if (x.segments_out().front().gso_size() > 0) {
+            for (auto &piece : x.segments_out().front().split()) {
+                segments.emplace_back(move(piece));
+            }
+        } else {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
+    // merge runs of in-order pieces back together, as TCPSpongeSocket does with TCPConfig::gro
+    if (gro) {
+        segments = TCPSegment::coalesce(move(segments), TCPConfig::MAX_GSO_SIZE);
+    }
     if (reorder) {
         for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
             y.segment_received(move(*it));
@@ -28,8 +43,15 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder,
+               const bool zero_copy = false,
+               const uint16_t mss = TCPConfig::MAX_PAYLOAD_SIZE,
+               const bool gso = false,
+               const bool gro = false) {
     TCPConfig config;
+    config.zero_copy_send = zero_copy;
+    config.mss = mss;
+    config.gso = gso;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -66,7 +88,7 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
+        move_segments(x, y, segments, reorder, gro);
         move_segments(y, x, segments, false);
 
         // read output from y
@@ -95,8 +117,15 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    if (mss != TCPConfig::MAX_PAYLOAD_SIZE or gso or gro) {
+        const auto label = gso ? (gro ? ", GSO+GRO" : ", GSO    ") : (gro ? ", GRO    " : "         ");
+        const auto segments = (len + mss - 1) / mss;
+        cout << "CPU-limited throughput with MSS " << setw(5) << mss << label << ": " << gigabits_per_second
+             << " Gbit/s, " << setw(6) << double(duration) / segments << " ns per MSS-sized segment\n";
+    } else {
+        const auto label = reorder ? " with reordering: " : (zero_copy ? " with zero-copy : " : "                : ");
+        cout << "CPU-limited throughput" << label << gigabits_per_second << " Gbit/s\n";
+    }
 
     while (x.active() or y.active()) {
         loop();
@@ -107,6 +136,20 @@ int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
+        // segments sized for common MTUs: minimum IPv4, Ethernet, jumbo frames, 16 KiB
+        for (const uint16_t mss : {536, 1460, 8960, 16384}) {
+            main_loop(false, false, mss);
+        }
+        // the same, with each window's new data queued as one super-segment
+        for (const uint16_t mss : {536, 1000, 1460}) {
+            main_loop(false, false, mss, true);
+        }
+        // the same again, with the receiver taking each burst's in-order segments as one
+        for (const uint16_t mss : {536, 1000, 1460}) {
+            main_loop(false, false, mss, false, true);
+            main_loop(false, false, mss, true, true);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -31,6 +31,20 @@ static void show_usage(const char *argv0, const char *msg) {
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+         << "   -M <mss>        Send and accept segments of up to <mss> bytes   " << TCPConfig::MAX_PAYLOAD_SIZE
+         << "\n\n"
+
+         << "   -R <min>        Adapt the RTO to the measured RTT, >= <min> ms  (fixed RTO)\n\n"
+
+         << "   -D <ms>         Delay ACKs by up to <ms> ms, or two segments    0\n\n"
+
+         << "   -P <rate>       Pace segments at <rate> bytes/ms (0: estimate)  (no pacing)\n\n"
+
+         << "   -G              Cut super-segments into MSS-sized ones (GSO)    (off)\n"
+         << "   -g              Merge in-order segments on arrival (GRO)        (off)\n\n"
+
+         << "   -C <cc>         Congestion control: none, newreno or cubic      none\n\n"
+
          << "   -d <tapdev>     Connect to tap <tapdev>                         " << TAP_DFLT << "\n\n"
 
          << "   -h              Show this message.\n\n";
@@ -85,6 +99,49 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-M", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -M requires one argument.");
+            c_fsm.mss = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-R", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -R requires one argument.");
+            c_fsm.adaptive_rto = true;
+            c_fsm.rto_min = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-D", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -D requires one argument.");
+            c_fsm.ack_delay = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -P requires one argument.");
+            c_fsm.pacing = true;
+            c_fsm.pacing_rate = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            c_fsm.gso = true;
+            curr += 1;
+
+        } else if (strncmp("-g", argv[curr], 3) == 0) {
+            c_fsm.gro = true;
+            curr += 1;
+
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -C requires one argument.");
+            const string algorithm = argv[curr + 1];
+            if (algorithm == "newreno") {
+                c_fsm.congestion_control = TCPConfig::Congestion::NewReno;
+            } else if (algorithm == "cubic") {
+                c_fsm.congestion_control = TCPConfig::Congestion::Cubic;
+            } else if (algorithm != "none") {
+                show_usage(argv[0], "ERROR: -C takes none, newreno or cubic.");
+                exit(1);
+            }
+            curr += 2;
+
         } else if (strncmp("-d", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -t requires one argument.");
             tapdev = argv[curr + 1];
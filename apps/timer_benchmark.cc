@@ -0,0 +1,121 @@
+#include "tcp_connection.hh"
+#include "timing_wheel.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t N_CONNECTIONS = 100000;
+static constexpr size_t N_BUSY = 1000;  // connections with a byte in flight that will never be acknowledged
+static constexpr size_t TICK_MS = 10;
+static constexpr size_t N_TICKS = 1000;  // ten seconds
+
+//! Hand every segment `from` has queued to `to`
+static void deliver(TCPConnection &from, TCPConnection &to) {
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+    }
+}
+
+//! Take `conn` to ESTABLISHED by handshaking with a peer that then vanishes, and maybe leave a byte in flight
+static void establish(TCPConnection &conn, const bool busy) {
+    TCPConnection peer{TCPConfig{}};
+    conn.connect();
+    deliver(conn, peer);
+    deliver(peer, conn);
+    deliver(conn, peer);
+    if (conn.state() != TCPState::State::ESTABLISHED) {
+        throw runtime_error("handshake failed: " + conn.state().name());
+    }
+    if (busy) {
+        conn.write("x");
+    }
+    conn.segments_out() = {};
+}
+
+//! Discard a connection's outgoing segments, counting them
+static size_t drain(TCPConnection &conn) {
+    const size_t count = conn.segments_out().size();
+    conn.segments_out() = {};
+    return count;
+}
+
+//! Time `N_TICKS` calls of `tick`, which returns how many segments went out
+static size_t run(const string &name, const function<size_t()> &tick) {
+    size_t sent = 0;
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < N_TICKS; i++) {
+        sent += tick();
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << name << ": " << double(duration) / N_TICKS / 1000 << " us/tick, "
+         << double(duration) / N_TICKS / N_CONNECTIONS << " ns/connection/tick, " << sent << " retransmissions\n";
+    return sent;
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(2);
+        cout << N_CONNECTIONS << " established connections (" << N_BUSY << " waiting on an ACK), " << N_TICKS
+             << " ticks of " << TICK_MS << " ms\n";
+
+        // every connection counts its own milliseconds, so every tick visits all of them
+        size_t sent_per_connection = 0;
+        {
+            vector<TCPConnection> conns;
+            conns.reserve(N_CONNECTIONS);
+            for (size_t i = 0; i < N_CONNECTIONS; i++) {
+                conns.emplace_back(TCPConfig{});
+                establish(conns.back(), i < N_BUSY);
+            }
+            sent_per_connection = run("tick() per connection", [&] {
+                size_t sent = 0;
+                for (auto &conn : conns) {
+                    conn.tick(TICK_MS);
+                    sent += drain(conn);
+                }
+                return sent;
+            });
+        }
+
+        // one wheel for all connections, so a tick only visits the connections whose timers expire
+        size_t sent_shared = 0;
+        {
+            auto wheel = make_shared<TimingWheel>();
+            vector<TCPConnection> conns;
+            conns.reserve(N_CONNECTIONS);
+            for (size_t i = 0; i < N_CONNECTIONS; i++) {
+                conns.emplace_back(TCPConfig{}, wheel, i);
+                establish(conns.back(), i < N_BUSY);
+            }
+            sent_shared = run("shared TimingWheel", [&] {
+                size_t sent = 0;
+                wheel->advance(TICK_MS, [&](const uint64_t token) {
+                    TCPConnection &conn = conns[TCPConnection::timer_owner(token)];
+                    conn.timer_expired(token);
+                    sent += drain(conn);
+                });
+                return sent;
+            });
+        }
+
+        if (sent_per_connection != sent_shared) {
+            throw runtime_error("the two ways of keeping time retransmitted differently");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_header.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! A TCP-in-UDP datagram carrying a full MSS
+static constexpr size_t DATAGRAM_SIZE = TCPHeader::LENGTH + TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr size_t BATCH = UDPSocket::MAX_GSO_SEGMENTS;
+static constexpr size_t COUNT = BATCH * 4096;
+static constexpr int IDLE_MS = 200;
+
+//! Bytes received so far; the sender stays within a batch of it, so that the receive buffer doesn't overflow
+static atomic<size_t> received_bytes{0};
+
+//! Wait until the receiver is within a batch of `sent`, or for IDLE_MS / 2 if a datagram has been lost
+static void wait_for_receiver(const size_t sent) {
+    const auto deadline = steady_clock::now() + milliseconds(IDLE_MS / 2);
+    while (sent > received_bytes + BATCH * DATAGRAM_SIZE and steady_clock::now() < deadline) {
+        this_thread::yield();
+    }
+}
+
+enum class Mode { Plain, Batch, Offload };
+
+//! Receive until every datagram has come or the sender has gone quiet for IDLE_MS
+//! \returns when the last datagram came
+static steady_clock::time_point receive(UDPSocket &sock, const Mode mode) {
+    vector<UDPSocket::received_datagram> batch(BATCH, {{nullptr, 0}, {}});
+    auto last = steady_clock::now();
+    pollfd pfd{sock.fd_num(), POLLIN, 0};
+    while (received_bytes < COUNT * DATAGRAM_SIZE and SystemCall("poll", ::poll(&pfd, 1, IDLE_MS)) > 0) {
+        if (mode == Mode::Plain) {
+            sock.recv(batch[0]);
+            received_bytes += batch[0].payload.size();
+        } else {
+            const size_t n = sock.recv_batch(batch, BATCH);
+            for (size_t i = 0; i < n; i++) {
+                received_bytes += batch[i].payload.size();
+            }
+        }
+        last = steady_clock::now();
+    }
+    return last;
+}
+
+//! Send COUNT datagrams: one sendto() each, BATCH per sendmmsg(), or BATCH per payload that UDP GSO cuts up
+static void send(UDPSocket &sock, const Address &destination, const Mode mode) {
+    const string datagram(DATAGRAM_SIZE, 'x');
+    switch (mode) {
+        case Mode::Plain:
+            for (size_t i = 0; i < COUNT; i++) {
+                wait_for_receiver(i * DATAGRAM_SIZE);
+                sock.sendto(destination, datagram);
+            }
+            break;
+        case Mode::Batch: {
+            const vector<BufferViewList> batch(BATCH, datagram);
+            for (size_t i = 0; i < COUNT; i += BATCH) {
+                wait_for_receiver(i * DATAGRAM_SIZE);
+                sock.sendto_batch(destination, batch);
+            }
+            break;
+        }
+        case Mode::Offload: {
+            const string run(BATCH * DATAGRAM_SIZE, 'x');
+            const vector<BufferViewList> payloads{run};
+            const vector<uint16_t> gso_sizes{DATAGRAM_SIZE};
+            for (size_t i = 0; i < COUNT; i += BATCH) {
+                wait_for_receiver(i * DATAGRAM_SIZE);
+                sock.sendto_batch(destination, payloads, gso_sizes);
+            }
+            break;
+        }
+    }
+}
+
+static void transfer(const Mode mode, const string &name) {
+    UDPSocket sender, receiver;
+    sender.bind(Address{"127.0.0.1", 0});
+    receiver.bind(Address{"127.0.0.1", 0});
+    if (mode == Mode::Offload) {
+        try {
+            sender.set_gso_size(0);
+            receiver.set_gro(true);
+        } catch (const unix_error &e) {
+            cout << setw(17) << name << ": unavailable (" << e.what() << ")\n";
+            return;
+        }
+    }
+
+    received_bytes = 0;
+    steady_clock::time_point last;
+    thread receiving([&] { last = receive(receiver, mode); });
+    const auto start = steady_clock::now();
+    send(sender, receiver.local_address(), mode);
+    receiving.join();
+
+    const double seconds = duration_cast<duration<double>>(last - start).count();
+    cout << setw(17) << name << ": " << setw(7) << received_bytes / seconds / 1e6 << " MB/s, " << setw(7)
+         << seconds * 1e9 / COUNT << " ns per datagram, " << setw(4)
+         << 100.0 * (1.0 - double(received_bytes) / double(COUNT * DATAGRAM_SIZE)) << "% lost\n";
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(1);
+        cout << COUNT << " datagrams of " << DATAGRAM_SIZE << " bytes over loopback:\n";
+        transfer(Mode::Plain, "sendto/recv");
+        transfer(Mode::Batch, "sendmmsg/recvmmsg");
+        transfer(Mode::Offload, "UDP GSO/GRO");
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -30,18 +30,24 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_mem         COMMAND fsm_stream_reassembler_mem)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_chunked      COMMAND byte_stream_chunked)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
 add_test(NAME arp_network_interface    COMMAND net_interface)
 
 add_test(NAME router_test    COMMAND network_simulator)
+add_test(NAME router_test_dir24_8    COMMAND network_simulator dir24_8)
+add_test(NAME router_ipv4_forward    COMMAND ipv4_forward)
+add_test(NAME router_prefix_trie    COMMAND prefix_trie)
+add_test(NAME router_dir24_8_table    COMMAND dir24_8_table)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
@@ -66,6 +72,20 @@ add_test(NAME t_reorder              COMMAND fsm_reorder)
 add_test(NAME t_address_dt           COMMAND address_dt)
 add_test(NAME t_parser_dt            COMMAND parser_dt)
 add_test(NAME t_socket_dt            COMMAND socket_dt)
+add_test(NAME t_eventloop            COMMAND eventloop)
+add_test(NAME t_checksum             COMMAND checksum)
+add_test(NAME t_timing_wheel         COMMAND timing_wheel)
+add_test(NAME t_congestion_control   COMMAND congestion_control)
+add_test(NAME t_rtt_estimation       COMMAND rtt_estimation)
+add_test(NAME t_window_scaling       COMMAND window_scaling)
+add_test(NAME t_sack                 COMMAND sack)
+add_test(NAME t_delayed_ack          COMMAND delayed_ack)
+add_test(NAME t_mss_option           COMMAND mss_option)
+add_test(NAME t_pacing               COMMAND pacing)
+add_test(NAME t_gso                  COMMAND gso)
+add_test(NAME t_gro                  COMMAND gro)
+add_test(NAME t_udp_batch            COMMAND udp_batch)
+add_test(NAME t_udp_offload          COMMAND udp_offload)
 
 add_test(NAME t_udp_client_send      COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -ucS)
 add_test(NAME t_udp_server_send      COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -usS)
@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -9,32 +12,150 @@
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity)
-    : _capacity(capacity), _queue(), _written_size(0), _read_size(0), _input_ended(false), _error(false) {}
+ByteStream::ByteStream(const size_t capacity, const Storage storage)
+    : _capacity(capacity)
+    , _storage(storage)
+    , _buffer()
+    , _head(0)
+    , _chunks()
+    , _chunk_storage(0)
+    , _size(0)
+    , _written_size(0)
+    , _read_size(0)
+    , _input_ended(false)
+    , _error(false) {}
+
+//! \details Storage grows geometrically (capped at the stream's capacity) so an idle
+//! stream costs nothing; growing relinearizes the contents so `_head` becomes 0.
+void ByteStream::reserve(const size_t size) {
+    if (size <= _buffer.size()) {
+        return;
+    }
+    vector<char> grown(max(size, min(_capacity, 2 * _buffer.size())));
+    copy_out(grown.data(), _size);
+    _buffer.swap(grown);
+    _head = 0;
+}
+
+void ByteStream::copy_out(char *dst, const size_t len) const {
+    if (len == 0) {
+        return;
+    }
+    if (_storage == Storage::Chunked) {
+        size_t copied = 0;
+        for (auto it = _chunks.begin(); copied < len; ++it) {
+            const size_t n = min(len - copied, it->size());
+            memcpy(dst + copied, it->str().data(), n);
+            copied += n;
+        }
+        return;
+    }
+    const size_t first = min(len, _buffer.size() - _head);
+    memcpy(dst, _buffer.data() + _head, first);
+    memcpy(dst + first, _buffer.data(), len - first);
+}
+
+void ByteStream::write_ring(const string_view data) {
+    reserve(_size + data.size());
+
+    // 写入位置可能绕回到缓冲区开头，因此最多拆成两次拷贝
+    const size_t tail = (_head + _size) % _buffer.size();
+    const size_t first = min(data.size(), _buffer.size() - tail);
+    memcpy(_buffer.data() + tail, data.data(), first);
+    memcpy(_buffer.data(), data.data() + first, data.size() - first);
+}
 
 size_t ByteStream::write(const string &data) {
+    if (_storage == Storage::Chunked) {
+        return write(Buffer{data.substr(0, min(data.size(), remaining_capacity()))});
+    }
     if (_input_ended)
         return 0;
-    size_t size_to_write = min(data.size(), _capacity - _queue.size());
-    for (size_t i = 0; i < size_to_write; i++) {
-        _queue.push_back(data[i]);
+    size_t size_to_write = min(data.size(), remaining_capacity());
+    if (size_to_write == 0) {
+        return 0;
     }
+    write_ring({data.data(), size_to_write});
+    _size += size_to_write;
+    _written_size += size_to_write;
+    return size_to_write;
+}
+
+size_t ByteStream::write(string &&data) {
+    if (_storage == Storage::Ring) {
+        return write(static_cast<const string &>(data));
+    }
+    return write(Buffer{move(data)});
+}
+
+//! \param[in] data is kept by reference (trimmed to the remaining capacity) when the stream is
+//! Storage::Chunked (unless it is a small part of its storage), and copied into the circular buffer otherwise
+size_t ByteStream::write(Buffer data) {
+    if (_input_ended)
+        return 0;
+    size_t size_to_write = min(data.size(), remaining_capacity());
+    if (size_to_write == 0) {
+        return 0;
+    }
+    if (_storage == Storage::Chunked) {
+        data.remove_suffix(data.size() - size_to_write);
+        data.compact();
+        _chunk_storage += data.storage_size();
+        _chunks.push_back(move(data));
+    } else {
+        write_ring(data.str().substr(0, size_to_write));
+    }
+    _size += size_to_write;
     _written_size += size_to_write;
     return size_to_write;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    size_t peek_size = min(len, _queue.size());
-    return string(_queue.begin(), _queue.begin() + peek_size);
+    string ret(min(len, _size), '\0');
+    copy_out(ret.data(), ret.size());
+    return ret;
+}
+
+//! \param[in] len bytes will be viewed from the output side of the buffer
+BufferViewList ByteStream::peek_output_views(const size_t len) const {
+    const size_t peek_size = min(len, _size);
+    deque<string_view> views;
+    if (_storage == Storage::Chunked) {
+        size_t viewed = 0;
+        for (auto it = _chunks.begin(); viewed < peek_size; ++it) {
+            views.push_back(it->str().substr(0, peek_size - viewed));
+            viewed += views.back().size();
+        }
+    } else if (peek_size > 0) {
+        const size_t first = min(peek_size, _buffer.size() - _head);
+        views.emplace_back(_buffer.data() + _head, first);
+        if (peek_size > first) {
+            views.emplace_back(_buffer.data(), peek_size - first);
+        }
+    }
+    return BufferViewList(move(views));
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     // Attention: according to the test case, _read_size is updata here!!!
-    size_t pop_size = min(len, _queue.size());
-    _queue.erase(_queue.begin(), _queue.begin() + pop_size);
-    ;
+    size_t pop_size = min(len, _size);
+    _size -= pop_size;
+    if (_storage == Storage::Chunked) {
+        while (pop_size > 0) {
+            if (pop_size < _chunks.front().size()) {
+                _chunks.front().remove_prefix(pop_size);
+                pop_size = 0;
+            } else {
+                pop_size -= _chunks.front().size();
+                _chunk_storage -= _chunks.front().storage_size();
+                _chunks.pop_front();
+            }
+        }
+    } else {
+        _head = _size == 0 ? 0 : (_head + pop_size) % _buffer.size();
+    }
     _read_size += len;
 }
 
@@ -47,18 +168,34 @@ std::string ByteStream::read(const size_t len) {
     return read_data;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \returns a Buffer sharing storage with the written chunk when possible, otherwise a copy
+Buffer ByteStream::read_buffer(const size_t len) {
+    const size_t read_size = min(len, _size);
+    if (_storage == Storage::Chunked and read_size > 0 and _chunks.front().size() >= read_size) {
+        Buffer ret = _chunks.front();
+        ret.remove_suffix(ret.size() - read_size);
+        pop_output(read_size);
+        return ret;
+    }
+    return Buffer{read(read_size)};
+}
+
 void ByteStream::end_input() { _input_ended = true; }
 
 bool ByteStream::input_ended() const { return _input_ended; }
 
-size_t ByteStream::buffer_size() const { return _queue.size(); }
+size_t ByteStream::buffer_size() const { return _size; }
 
-bool ByteStream::buffer_empty() const { return _queue.empty(); }
+bool ByteStream::buffer_empty() const { return _size == 0; }
 
-bool ByteStream::eof() const { return _queue.empty() && _input_ended; }
+bool ByteStream::eof() const { return buffer_empty() && _input_ended; }
 
 size_t ByteStream::bytes_written() const { return _written_size; }
 
 size_t ByteStream::bytes_read() const { return _read_size; }
 
-size_t ByteStream::remaining_capacity() const { return _capacity - _queue.size(); }
+//! \note Each chunk counts all of the storage it keeps alive, so storage shared between chunks counts more than once.
+size_t ByteStream::memory_usage() const { return _buffer.capacity() + _chunk_storage; }
+
+size_t ByteStream::remaining_capacity() const { return _capacity - _size; }
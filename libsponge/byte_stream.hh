@@ -1,8 +1,12 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
-#include <queue>
+#include "buffer.hh"
+
+#include <deque>
 #include <string>
+#include <string_view>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
@@ -10,6 +14,13 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream holds buffered bytes
+    enum class Storage {
+        Ring,    //!< Bytes are copied into a circular buffer
+        Chunked  //!< Written Buffers are kept as refcounted slices, so owned writes are never copied
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -18,17 +29,31 @@ class ByteStream {
     // that's a sign that you probably want to keep exploring
     // different approaches.
 
-    size_t _capacity;         //!< Maximum number of bytes that can be written.
-    std::deque<char> _queue;  //!< Buffer of bytes.
-    size_t _written_size;     //!<  Number of bytes written.
-    size_t _read_size;        //!< Number of bytes read.
-    bool _input_ended;        //!< Flag indicating that the input has ended.
+    size_t _capacity;            //!< Maximum number of bytes that can be written.
+    Storage _storage;            //!< Which of the two representations below holds the bytes.
+    std::vector<char> _buffer;   //!< Circular buffer of bytes, grown on demand up to `_capacity`.
+    size_t _head;                //!< Index in `_buffer` of the first unread byte.
+    std::deque<Buffer> _chunks;  //!< Queue of written slices (Storage::Chunked only).
+    size_t _chunk_storage;       //!< Storage kept alive by `_chunks` (see Buffer::storage_size()).
+    size_t _size;                //!< Number of bytes currently buffered.
+    size_t _written_size;        //!<  Number of bytes written.
+    size_t _read_size;           //!< Number of bytes read.
+    bool _input_ended;           //!< Flag indicating that the input has ended.
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    //! Make sure `_buffer` can hold at least `size` bytes, keeping the contents in order.
+    void reserve(const size_t size);
+
+    //! Copy the first `len` buffered bytes into `dst`.
+    void copy_out(char *dst, const size_t len) const;
+
+    //! Copy `data` into the circular buffer (Storage::Ring only).
+    void write_ring(const std::string_view data);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -38,6 +63,15 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes, taking ownership of it if the stream uses Storage::Chunked.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a Buffer, keeping a refcounted slice of it if the stream uses Storage::Chunked
+    //! (or a copy, if the slice is a small part of the Buffer's storage, see Buffer::compact()).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -55,6 +89,10 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views that stay valid until the next write or pop
+    BufferViewList peek_output_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -62,6 +100,11 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes of the stream as a single Buffer
+    //! \note With Storage::Chunked this is a refcounted slice (no copy) whenever
+    //! the bytes lie within one written chunk.
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -86,6 +129,9 @@ class ByteStream {
 
     //! Total number of bytes popped
     size_t bytes_read() const;
+
+    //! Heap memory held for buffered bytes (the circular buffer, or all of the storage the chunks keep alive)
+    size_t memory_usage() const;
     //!@}
 };
 
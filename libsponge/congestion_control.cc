@@ -0,0 +1,101 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+CongestionControl::CongestionControl(const size_t mss)
+    : _mss(mss), _cwnd(10 * mss), _ssthresh(numeric_limits<size_t>::max()) {}
+
+unique_ptr<CongestionControl> CongestionControl::make(const TCPConfig::Congestion algorithm, const size_t mss) {
+    switch (algorithm) {
+        case TCPConfig::Congestion::NewReno:
+            return make_unique<NewReno>(mss);
+        case TCPConfig::Congestion::Cubic:
+            return make_unique<Cubic>(mss);
+        case TCPConfig::Congestion::None:
+            break;
+    }
+    return nullptr;
+}
+
+size_t CongestionControl::slow_start(const size_t acked) {
+    if (_cwnd >= _ssthresh) {
+        return acked;
+    }
+    const size_t growth = min({acked, _mss, _ssthresh - _cwnd});
+    _cwnd += growth;
+    return _cwnd >= _ssthresh ? acked - growth : 0;
+}
+
+void NewReno::on_ack(const size_t acked, const size_t /* bytes_in_flight */, const uint64_t /* now */) {
+    // congestion avoidance: one more MSS for every cwnd's worth of acknowledged bytes
+    _bytes_acked += slow_start(acked);
+    while (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewReno::on_loss(const size_t bytes_in_flight, const uint64_t /* now */) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _ssthresh;
+    _bytes_acked = 0;
+}
+
+void NewReno::on_timeout(const size_t bytes_in_flight, const uint64_t /* now */) {
+    // back to slow start from a loss window of one segment
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _bytes_acked = 0;
+}
+
+void Cubic::reduce() {
+    const double segments = double(_cwnd) / _mss;
+    // fast convergence: if the window didn't get back to where it was last time, leave room for other flows
+    _w_max = segments < _w_max ? segments * (1 + BETA) / 2 : segments;
+    _ssthresh = max(size_t(_cwnd * BETA), 2 * _mss);
+    _in_epoch = false;
+    _bytes_acked = 0;
+}
+
+void Cubic::on_ack(const size_t acked, const size_t /* bytes_in_flight */, const uint64_t now) {
+    const size_t left = slow_start(acked);
+    if (left == 0) {
+        return;
+    }
+
+    const double segments = double(_cwnd) / _mss;
+    if (not _in_epoch) {
+        _in_epoch = true;
+        _epoch_start = now;
+        _k = segments < _w_max ? cbrt((_w_max - segments) / C) : 0;
+        _w_max = max(_w_max, segments);
+        _w_est = segments;
+    }
+
+    // the cubic's target for now, unless standard TCP (additive increase) would already be further along
+    const double t = double(now - _epoch_start) / 1000;
+    double target = C * (t - _k) * (t - _k) * (t - _k) + _w_max;
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * (double(left) / _mss) / segments;
+    target = min(max(target, _w_est), 1.5 * segments);
+
+    // grow by one MSS for every `segments / (target - segments)` segments acknowledged
+    _bytes_acked += left;
+    if (target > segments and _bytes_acked * (target - segments) >= segments * _mss) {
+        _bytes_acked = 0;
+        _cwnd += _mss;
+    }
+}
+
+void Cubic::on_loss(const size_t /* bytes_in_flight */, const uint64_t /* now */) {
+    reduce();
+    _cwnd = _ssthresh;
+}
+
+void Cubic::on_timeout(const size_t /* bytes_in_flight */, const uint64_t /* now */) {
+    reduce();
+    _cwnd = _mss;
+}
@@ -0,0 +1,92 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//! \brief How much a TCPSender may have in flight, as a congestion window that grows with
+//! acknowledgments and shrinks on loss.
+//!
+//! All sizes are in bytes (of sequence space); times are milliseconds on the sender's clock.
+class CongestionControl {
+  protected:
+    size_t _mss;       //!< Maximum segment size
+    size_t _cwnd;      //!< Congestion window
+    size_t _ssthresh;  //!< Slow-start threshold
+
+    //! Slow start: grow by up to one MSS per ACK (RFC 5681, 3.1)
+    //! \returns the part of `acked` left over once cwnd reaches ssthresh
+    size_t slow_start(const size_t acked);
+
+  public:
+    //! Start in slow start with an initial window of 10 segments (RFC 6928) and no threshold
+    explicit CongestionControl(const size_t mss);
+    virtual ~CongestionControl() = default;
+
+    //! \brief A congestion controller for `algorithm`
+    //! \returns nullptr for TCPConfig::Congestion::None
+    static std::unique_ptr<CongestionControl> make(const TCPConfig::Congestion algorithm, const size_t mss);
+
+    //! Name of the algorithm, for reports
+    virtual const char *name() const = 0;
+
+    //! The congestion window
+    size_t cwnd() const { return _cwnd; }
+
+    //! The slow-start threshold
+    size_t ssthresh() const { return _ssthresh; }
+
+    //! `acked` bytes were newly acknowledged, leaving `bytes_in_flight` outstanding
+    virtual void on_ack(const size_t acked, const size_t bytes_in_flight, const uint64_t now) = 0;
+
+    //! A loss was detected while `bytes_in_flight` were outstanding, without waiting for a timeout
+    virtual void on_loss(const size_t bytes_in_flight, const uint64_t now) = 0;
+
+    //! The retransmission timer expired with `bytes_in_flight` outstanding
+    virtual void on_timeout(const size_t bytes_in_flight, const uint64_t now) = 0;
+};
+
+//! \brief NewReno (RFC 5681, RFC 6582): additive increase of one MSS per window, halve on loss
+class NewReno : public CongestionControl {
+  private:
+    size_t _bytes_acked = 0;  //!< Acknowledged in congestion avoidance since cwnd last grew
+
+  public:
+    using CongestionControl::CongestionControl;
+
+    const char *name() const override { return "NewReno"; }
+    void on_ack(const size_t acked, const size_t bytes_in_flight, const uint64_t now) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now) override;
+    void on_timeout(const size_t bytes_in_flight, const uint64_t now) override;
+};
+
+//! \brief CUBIC (RFC 8312): after a loss, cwnd follows a cubic function of the time since the loss,
+//! centered on the window where the loss happened, so it regrows independently of the RTT
+class Cubic : public CongestionControl {
+  private:
+    static constexpr double C = 0.4;     //!< Scales the cubic, in segments per second cubed
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    double _w_max = 0;          //!< Window (in segments) before the last reduction
+    double _k = 0;              //!< Seconds from the epoch until the cubic regains `_w_max`
+    double _w_est = 0;          //!< Window (in segments) that standard TCP would have reached by now
+    bool _in_epoch = false;     //!< Whether `_epoch_start` is set
+    uint64_t _epoch_start = 0;  //!< When the current congestion-avoidance epoch began
+    size_t _bytes_acked = 0;    //!< Acknowledged since cwnd last grew
+
+    //! Cut the window after a loss, remembering where it was
+    void reduce();
+
+  public:
+    using CongestionControl::CongestionControl;
+
+    const char *name() const override { return "CUBIC"; }
+    void on_ack(const size_t acked, const size_t bytes_in_flight, const uint64_t now) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now) override;
+    void on_timeout(const size_t bytes_in_flight, const uint64_t now) override;
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
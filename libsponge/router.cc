@@ -1,6 +1,7 @@
 #include "router.hh"
 
 #include <iostream>
+#include <utility>
 
 using namespace std;
 
@@ -30,32 +31,39 @@ void Router::add_route(const uint32_t route_prefix,
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
     // Your code here.
-    _routing_table.push_back({route_prefix, prefix_length, next_hop, interface_num});
+    if (_flat_routing_table)
+        _flat_routing_table->insert(route_prefix, prefix_length, {next_hop, interface_num});
+    else
+        _routing_table.insert(route_prefix, prefix_length, {next_hop, interface_num});
+}
+
+//! \param[in] route_prefix The "up-to-32-bit" IPv4 address prefix of the route to remove
+//! \param[in] prefix_length The number of high-order bits of route_prefix that make up the prefix
+bool Router::remove_route(const uint32_t route_prefix, const uint8_t prefix_length) {
+    if (_flat_routing_table)
+        return _flat_routing_table->erase(route_prefix, prefix_length);
+    return _routing_table.erase(route_prefix, prefix_length);
 }
 
 //! \param[in] dgram The datagram to be routed
 void Router::route_one_datagram(InternetDatagram &dgram) {
     // Your code here.
     // 获取dst ip
-    uint32_t dst_ip = dgram.header().dst;
-    auto max_match_entry = _routing_table.end();
-
-    // 查询路由表，找到最长匹配的entry
-    for (auto it = _routing_table.begin(); it != _routing_table.end(); ++it) {
-        // prefix_length == 0 时是默认路由
-        if (it->prefix_length != 0 && (dst_ip ^ it->route_prefix) >> (32 - it->prefix_length) != 0)
-            continue;
-        if (max_match_entry == _routing_table.end() || max_match_entry->prefix_length < it->prefix_length)
-            max_match_entry = it;
-    }
+    // 只读访问报头，避免丢弃解析时保留的报头字节
+    const IPv4Header &header = as_const(dgram).header();
+    uint32_t dst_ip = header.dst;
+
+    // 查询路由表，找到最长匹配的entry（prefix_length == 0 时是默认路由）
+    const RoutingTableEntry *max_match_entry =
+        _flat_routing_table ? _flat_routing_table->lookup(dst_ip) : _routing_table.lookup(dst_ip);
 
     // If no routes matched, the router drops the datagram.
-    if (max_match_entry == _routing_table.end())
+    if (max_match_entry == nullptr)
         return;
 
-    // ttl 大于 1，则转发
-    if (dgram.header().ttl > 1) {
-        dgram.header().ttl--;
+    // ttl 大于 1，则转发（增量更新 ttl 和校验和，不重新序列化报头）
+    if (header.ttl > 1) {
+        dgram.decrement_ttl();
         AsyncNetworkInterface &interface = _interfaces[max_match_entry->interface_num];
         if (max_match_entry->next_hop.has_value())
             interface.send_datagram(dgram, max_match_entry->next_hop.value());
@@ -74,3 +82,7 @@ void Router::route() {
         }
     }
 }
+
+size_t Router::fib_memory_usage() const {
+    return _flat_routing_table ? _flat_routing_table->memory_usage() : _routing_table.memory_usage();
+}
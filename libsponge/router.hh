@@ -1,8 +1,11 @@
 #ifndef SPONGE_LIBSPONGE_ROUTER_HH
 #define SPONGE_LIBSPONGE_ROUTER_HH
 
+#include "dir24_8_table.hh"
 #include "network_interface.hh"
+#include "prefix_trie.hh"
 
+#include <memory>
 #include <optional>
 #include <queue>
 
@@ -41,6 +44,14 @@ class AsyncNetworkInterface : public NetworkInterface {
 //! \brief A router that has multiple network interfaces and
 //! performs longest-prefix-match routing between them.
 class Router {
+  public:
+    //! How the router stores its forwarding table
+    enum class Fib {
+        Trie,    //!< A path-compressed prefix trie: compact, lookups take up to 33 memory accesses
+        Dir24_8  //!< A DIR-24-8 table: at least 64 MiB, lookups take one or two memory accesses
+    };
+
+  private:
     //! The router's collection of network interfaces
     std::vector<AsyncNetworkInterface> _interfaces{};
 
@@ -52,14 +63,19 @@ class Router {
   private:
     // router table entry
     struct RoutingTableEntry {
-        uint32_t route_prefix;
-        uint8_t prefix_length;
         std::optional<Address> next_hop;
         size_t interface_num;
     };
-    std::vector<RoutingTableEntry> _routing_table{};
+    //! 路由表，以前缀为键，支持最长前缀匹配
+    PrefixTrie<RoutingTableEntry> _routing_table{};
+    //! 选择 Fib::Dir24_8 时使用的路由表（此时不使用 _routing_table）
+    std::unique_ptr<Dir24_8Table<RoutingTableEntry>> _flat_routing_table;
 
   public:
+    //! \param[in] fib how to store the forwarding table
+    explicit Router(const Fib fib = Fib::Trie)
+        : _flat_routing_table(fib == Fib::Dir24_8 ? std::make_unique<Dir24_8Table<RoutingTableEntry>>() : nullptr) {}
+
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
     //! \returns The index of the interface after it has been added to the router
@@ -71,14 +87,21 @@ class Router {
     //! Access an interface by index
     AsyncNetworkInterface &interface(const size_t N) { return _interfaces.at(N); }
 
-    //! Add a route (a forwarding rule)
+    //! Add a route (a forwarding rule), replacing any existing route for the same prefix
     void add_route(const uint32_t route_prefix,
                    const uint8_t prefix_length,
                    const std::optional<Address> next_hop,
                    const size_t interface_num);
 
+    //! Remove the route for exactly this prefix
+    //! \returns `true` if such a route existed
+    bool remove_route(const uint32_t route_prefix, const uint8_t prefix_length);
+
     //! Route packets between the interfaces
     void route();
+
+    //! Bytes used by the forwarding table
+    size_t fib_memory_usage() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_ROUTER_HH
@@ -6,60 +6,102 @@
 // automated checks run by `make check_lab1`.
 
 // You will need to add private members to the class declaration in `stream_reassembler.hh`
-#include <iostream>
+#include <iterator>
+
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity)
-    : _unassembled_queue(capacity, '\0')
-    , _flags_queue(capacity, false)
+StreamReassembler::StreamReassembler(const size_t capacity, const ByteStream::Storage storage)
+    : _unassembled_segments()
     , _is_eof(false)
     , _eof_idx(0)
     , _unassembled_size(0)
-    , _output(capacity)
+    , _output(capacity, storage)
     , _capacity(capacity) {}
 
-//! \details This function accepts a substring (aka a segment) of bytes,
-//! possibly out-of-order, from the logical stream, and assembles any newly
-//! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // substrings provided to the push substring() function may overlap
-    size_t first_unassembled = _output.bytes_written();
-    size_t first_unaccept = _output.bytes_read() + _capacity;
+//! \details Stored segments never overlap, so a new segment only has to be compared with the
+//! segment just before `start` and the segments beginning inside [start, end): bytes already held
+//! by the preceding segment are trimmed from the front, segments that are fully covered are
+//! replaced, and a segment that extends past `end` trims the new data's tail.
+void StreamReassembler::store_segment(const Buffer &data, const uint64_t index, uint64_t start, uint64_t end) {
+    auto it = _unassembled_segments.upper_bound(start);
+    if (it != _unassembled_segments.begin()) {
+        const auto prev_it = prev(it);
+        const uint64_t prev_end = prev_it->first + prev_it->second.size();
+        if (prev_end >= end) {
+            return;
+        }
+        start = max(start, prev_end);
+    }
 
-    // 处理那些在范围之外内的数据
-    // 注意，有可能数据在范围之外，但是其 eof 标志位为1，因此，对于在范围之外的数据不能简单丢弃
-    if (!(index >= first_unaccept || index + data.size() <= first_unassembled)) {
-        size_t begin_idx = max(index, first_unassembled);
-        size_t end_index = min(first_unaccept, index + data.size());
-
-        // 将数据存放到 _unassembled_queue 中
-        for (size_t i = begin_idx; i < end_index; i++) {
-            if (!_flags_queue[i - first_unassembled]) {
-                _unassembled_queue[i - first_unassembled] = data[i - index];
-                _unassembled_size++;
-                _flags_queue[i - first_unassembled] = true;
-            }
+    while (it != _unassembled_segments.end() && it->first < end) {
+        if (it->first + it->second.size() > end) {
+            end = it->first;
+            break;
         }
+        _unassembled_size -= it->second.size();
+        it = _unassembled_segments.erase(it);
+    }
 
-        // 将有序的数据写入 ByteStream
-        string to_write = "";
-        while (_flags_queue.front() && to_write.size() < _output.remaining_capacity()) {
-            to_write += _unassembled_queue.front();
-            _unassembled_queue.pop_front();
-            _flags_queue.pop_front();
-            // 入队占位，保持队列容量不变，类似滑动窗口
-            _unassembled_queue.emplace_back('\0');
-            _flags_queue.emplace_back(false);
+    if (start < end) {
+        Buffer slice = data;
+        slice.remove_prefix(start - index);
+        slice.remove_suffix(slice.size() - (end - start));
+        slice.compact();
+        _unassembled_segments.emplace_hint(it, start, move(slice));
+        _unassembled_size += end - start;
+    }
+}
+
+void StreamReassembler::flush_segments() {
+    while (!_unassembled_segments.empty()) {
+        const auto it = _unassembled_segments.begin();
+        const uint64_t first_unassembled = _output.bytes_written();
+        if (it->first > first_unassembled) {
+            break;
         }
 
-        if (to_write.size() > 0) {
-            _unassembled_size -= to_write.size();
-            _output.write(to_write);
+        const uint64_t start = it->first;
+        Buffer data = move(it->second);
+        _unassembled_segments.erase(it);
+        _unassembled_size -= data.size();
+
+        // 已经被直接写入的数据覆盖的部分需要丢弃
+        if (start + data.size() <= first_unassembled) {
+            continue;
         }
+        data.remove_prefix(first_unassembled - start);
+        _output.write(move(data));
+    }
+}
+
+pair<uint64_t, uint64_t> StreamReassembler::window(const uint64_t index, const size_t size) const {
+    // 窗口为 [第一个未重组的字节, 第一个不能接收的字节)
+    const uint64_t first_unassembled = _output.bytes_written();
+    const uint64_t first_unaccept = _output.bytes_read() + _capacity;
+    return {max(index, first_unassembled), min(index + size, first_unaccept)};
+}
+
+void StreamReassembler::accept(Buffer data, const uint64_t index) {
+    const auto [begin_idx, end_index] = window(index, data.size());
+    if (begin_idx >= end_index) {
+        return;
+    }
+
+    if (begin_idx == _output.bytes_written()) {
+        // 数据紧接在已重组的部分之后，直接整段写入 ByteStream，再把随之变得连续的数据一并写入
+        data.remove_prefix(begin_idx - index);
+        data.remove_suffix(data.size() - (end_index - begin_idx));
+        _output.write(move(data));
+        flush_segments();
+    } else {
+        store_segment(data, index, begin_idx, end_index);
     }
+}
 
+void StreamReassembler::check_eof(const uint64_t end, const bool eof) {
+    // 注意，有可能数据在范围之外，但是其 eof 标志位为1，因此，对于在范围之外的数据不能简单丢弃
     if (eof) {
-        _eof_idx = index + data.size();
+        _eof_idx = end;
         _is_eof = true;
     }
     if (_is_eof && _eof_idx == _output.bytes_written()) {
@@ -67,6 +109,50 @@ void StreamReassembler::push_substring(const string &data, const size_t index, c
     }
 }
 
+//! \details This function accepts a substring (aka a segment) of bytes,
+//! possibly out-of-order, from the logical stream, and assembles any newly
+//! contiguous substrings and writes them into the output stream in order.
+//! Only the bytes inside the window are copied.
+void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+    const auto [begin_idx, end_index] = window(index, data.size());
+    if (begin_idx < end_index) {
+        accept(Buffer{data.substr(begin_idx - index, end_index - begin_idx)}, begin_idx);
+    }
+    check_eof(index + data.size(), eof);
+}
+
+//! \details Bytes are only copied if the output stream is ByteStream::Storage::Ring, or if they are a small part
+//! of `data`'s storage (see Buffer::compact()).
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    // substrings provided to the push substring() function may overlap
+    const size_t data_size = data.size();
+    accept(move(data), index);
+    check_eof(index + data_size, eof);
+}
+
 size_t StreamReassembler::unassembled_bytes() const { return _unassembled_size; }
 
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    for (const auto &[start, data] : _unassembled_segments) {
+        // 相邻的片段合并为一个区间
+        if (!ranges.empty() && ranges.back().second == start) {
+            ranges.back().second += data.size();
+        } else {
+            ranges.emplace_back(start, start + data.size());
+        }
+    }
+    return ranges;
+}
+
+size_t StreamReassembler::memory_usage() const {
+    // 每个 map 节点除了键值对之外，还有颜色标记和三个指针
+    constexpr size_t node_overhead = 4 * sizeof(void *);
+    size_t usage = 0;
+    for (const auto &segment : _unassembled_segments) {
+        usage += node_overhead + sizeof(segment) + segment.second.storage_size();
+    }
+    return usage;
+}
+
 bool StreamReassembler::empty() const { return unassembled_bytes() == 0; }
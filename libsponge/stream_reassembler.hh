@@ -4,16 +4,19 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
-#include <deque>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
   private:
     // Your code here -- add private members as necessary.
-    std::deque<char> _unassembled_queue;
-    std::deque<bool> _flags_queue;  // 标记是否有数据
+    //! 乱序到达的数据，以起始下标为键，各区间 [start, start + size) 互不重叠
+    //! 保存的是收到的 Buffer 的切片，与报文共享存储，不需要拷贝
+    std::map<uint64_t, Buffer> _unassembled_segments;
     bool _is_eof;
     size_t _eof_idx;
     size_t _unassembled_size;
@@ -21,11 +24,27 @@ class StreamReassembler {
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
 
+    //! Store [start, end) of `data` (which begins at `index`), replacing any stored bytes it covers
+    void store_segment(const Buffer &data, const uint64_t index, uint64_t start, uint64_t end);
+
+    //! Write every stored segment that is now contiguous with the output stream
+    void flush_segments();
+
+    //! The part [first, second) of the stream indices [index, index + size) that is inside the window
+    std::pair<uint64_t, uint64_t> window(const uint64_t index, const size_t size) const;
+
+    //! Write or store the bytes of `data` (which begins at `index`) that are inside the window
+    void accept(Buffer data, const uint64_t index);
+
+    //! Note the end of the stream at `end` if `eof`, and end the output once every byte before it is written
+    void check_eof(const uint64_t end, const bool eof);
+
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param storage how the output stream holds reassembled bytes (see ByteStream::Storage)
+    StreamReassembler(const size_t capacity, const ByteStream::Storage storage = ByteStream::Storage::Ring);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -37,6 +56,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer
+    //! \details Same as above, but out-of-order bytes are kept as refcounted slices of `data`,
+    //! and with a ByteStream::Storage::Chunked output stream so are in-order bytes. A slice that is less
+    //! than half of `data`'s storage is copied instead, so that it doesn't keep the rest alive.
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -49,6 +74,16 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The stored substrings, merged into contiguous ranges [first, second) of stream indices
+    //! \returns the ranges in ascending order, so the holes are the gaps before and between them
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
+
+    //! \brief Memory held for out-of-order data, in bytes (excluding the output stream)
+    //! \note Slices count all of the storage they keep alive, which is less than twice their size.
+    //! \note Storage is only allocated when data arrives out of order, and is released as soon
+    //! as the holes are filled, so this is 0 for a receiver that only sees in-order data.
+    size_t memory_usage() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -12,24 +14,66 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! The smallest window scale that lets a window of `capacity` bytes be advertised in 16 bits
+static uint8_t window_shift_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WSCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
+
+TCPConnection::TCPConnection(const TCPConfig &cfg) : TCPConnection(cfg, make_shared<TimingWheel>(), 0) {
+    _owns_timer_wheel = true;
+}
+
+//! \param[in] cfg the connection's configuration
+//! \param[in] timer_wheel where to arm the connection's timers, shared with other connections
+//! \param[in] id identifies this connection in the tokens of its timers (see timer_owner())
+TCPConnection::TCPConnection(const TCPConfig &cfg, shared_ptr<TimingWheel> timer_wheel, const uint64_t id)
+    : _cfg{cfg}, _timer_wheel{move(timer_wheel)}, _timer_id{id}, _window_shift{window_shift_for(cfg.recv_capacity)} {}
+
 size_t TCPConnection::remaining_outbound_capacity() const { return _sender.stream_in().remaining_capacity(); }
 
 size_t TCPConnection::bytes_in_flight() const { return _sender.bytes_in_flight(); }
 
 size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_bytes(); }
 
-size_t TCPConnection::time_since_last_segment_received() const { return _time_since_last_segment_received; }
+size_t TCPConnection::time_since_last_segment_received() const {
+    return _timer_wheel->now() - _last_segment_received_at;
+}
+
+optional<size_t> TCPConnection::time_until_next_timeout() const {
+    optional<size_t> timeout = _sender.time_until_retransmission();
+    // 发送节奏控制下，下一个报文可以发送的时间
+    if (const auto pacing_left = _sender.time_until_paced_send()) {
+        timeout = timeout.has_value() ? min<size_t>(timeout.value(), pacing_left.value()) : pacing_left.value();
+    }
+    // time_wait 状态下等待的剩余时间
+    if (const auto linger_left = _linger_timer.time_left()) {
+        timeout = timeout.has_value() ? min<size_t>(timeout.value(), linger_left.value()) : linger_left.value();
+    }
+    // 延迟ack的剩余时间
+    if (const auto ack_left = _ack_timer.time_left()) {
+        timeout = timeout.has_value() ? min<size_t>(timeout.value(), ack_left.value()) : ack_left.value();
+    }
+    return timeout;
+}
 
 void TCPConnection::segment_received(const TCPSegment &seg) {
     // 如果接收到含有rst标记位的报文，则断开连接
-    _time_since_last_segment_received = 0;
+    _last_segment_received_at = _timer_wheel->now();
     // keep-alive
     if (_receiver.ackno().has_value() && seg.length_in_sequence_space() == 0 &&
         seg.header().seqno == _receiver.ackno().value() - 1) {
         _sender.send_empty_segment();
         send_segments();
+        update_linger_timer();
         return;
     }
+    // 报文是否正好接在已收到的数据之后，且之前没有乱序到达的数据
+    const bool in_order = _receiver.ackno().has_value() && seg.header().seqno == _receiver.ackno().value() &&
+                          _receiver.unassembled_bytes() == 0;
     _receiver.segment_received(seg);
 
     if (seg.header().rst) {
@@ -37,15 +81,35 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         _sender.stream_in().set_error();
         _linger_after_streams_finish = false;
         _is_alive = false;
+        _linger_timer.stop();
+        _ack_timer.stop();
         return;
     }
 
+    // 对方的SYN报文决定是否启用窗口扩大选项和SACK；SYN报文中的窗口大小本身不经过扩大 (RFC 7323)
+    // 发送的报文不能超过对方能接收的MSS
+    if (seg.header().syn) {
+        _window_scaling = _cfg.window_scaling && seg.header().wscale.has_value();
+        _sack = _cfg.sack && seg.header().sack_permitted;
+        _sender.set_remote_window_scale(0);
+        if (seg.header().mss.has_value()) {
+            _sender.set_mss(seg.header().mss.value());
+        }
+    }
+
     // 如果收到的报文设置了ack标志位，则将ackno和windowsize传输给_sender
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        _sender.ack_received(seg.header().ackno,
+                             seg.header().win,
+                             seg.length_in_sequence_space() > 0,
+                             _sack ? seg.header().sack : vector<TCPHeader::SackBlock>{});
         send_segments();
     }
 
+    if (seg.header().syn && _window_scaling) {
+        _sender.set_remote_window_scale(seg.header().wscale.value());
+    }
+
     // Listen -> syn-recvd
     if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::SYN_RECV &&
         TCPState::state_summary(_sender) == TCPSenderStateSummary::CLOSED) {
@@ -69,9 +133,32 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     // 发送ack报文
     if (seg.length_in_sequence_space() != 0 && _sender.segments_out().empty()) {
-        _sender.send_empty_segment();
-        send_segments();
+        acknowledge(seg, in_order);
+    }
+    update_linger_timer();
+}
+
+//! \details With TCPConfig::ack_delay set, an in-order segment is acknowledged once a second full
+//! segment's worth of data is waiting for an ACK, or when the delay runs out (RFC 1122 4.2.3.2, RFC 5681 4.2).
+//! SYN and FIN, out-of-order segments and segments that fill a hole are acknowledged at once, so that
+//! the peer's handshake, fast retransmit and recovery are not held up.
+void TCPConnection::acknowledge(const TCPSegment &seg, const bool in_order) {
+    if (_cfg.ack_delay > 0 && in_order && !seg.header().syn && !seg.header().fin &&
+        _receiver.unassembled_bytes() == 0 && _last_ackno_sent.has_value()) {
+        const auto unacknowledged = static_cast<size_t>(_receiver.ackno().value() - _last_ackno_sent.value());
+        // 数据已经随着发出的报文确认过了
+        if (unacknowledged == 0) {
+            return;
+        }
+        if (unacknowledged < 2 * _sender.mss()) {
+            if (!_ack_timer.running()) {
+                _ack_timer.start(_cfg.ack_delay);
+            }
+            return;
+        }
     }
+    _sender.send_empty_segment();
+    send_segments();
 }
 
 bool TCPConnection::active() const { return _is_alive; }
@@ -84,9 +171,50 @@ size_t TCPConnection::write(const string &data) {
     return w_size;
 }
 
+size_t TCPConnection::write(string &&data) {
+    size_t w_size = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    send_segments();
+    return w_size;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
-    _sender.tick(ms_since_last_tick);
+    if (_owns_timer_wheel) {
+        _timer_wheel->advance(ms_since_last_tick, [this](const uint64_t token) { timer_expired(token); });
+    }
+}
+
+void TCPConnection::timer_expired(const uint64_t token) {
+    // 在tcp连接进入time_wait状态时，当等待的时间超过一定上限，则可以 clean close
+    // time wait 状态是主动发起fin报文才回出现的状态
+    // 发送fin报文后，状态由establish -> fin_wait1
+    // 收到ack：fin_wait1 -> fin_wait2
+    // 收到对方的fin报文并发送ack： fin_wait2 -> time_wait
+    // 过了 2MSL ：fin_wait2 -> closed
+    // 各种状态在sender以及receiver上的表现参考tcp_state.hh 和 tcp_state.cc
+    switch (token & ((1 << TIMER_BITS) - 1)) {
+        case LINGER_TIMER:
+            _is_alive = false;
+            _linger_after_streams_finish = false;
+            return;
+        case PACING_TIMER:
+            // 有了新的发送额度，继续发送
+            _sender.pacing_timer_expired();
+            send_segments();
+            return;
+        case ACK_TIMER:
+            // 延迟的ack到期，发送出去
+            if (_is_alive) {
+                _sender.send_empty_segment();
+                send_segments();
+            }
+            return;
+        default:
+            break;
+    }
+
+    _sender.retransmission_timer_expired();
 
     // 查看重传次数，如果超时，发送rst报文
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
@@ -97,22 +225,18 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         _is_alive = false;
         return;
     }
-    //发送报文，因为sender在调用tick函数之后有可能重传报文
+    //发送报文，因为sender在超时之后有可能重传报文
     send_segments();
-    _time_since_last_segment_received += ms_since_last_tick;
+}
 
-    // 在tcp连接进入time_wait状态时，当等待的时间超过一定上限，则可以 clean close
-    // time wait 状态是主动发起fin报文才回出现的状态
-    // 发送fin报文后，状态由establish -> fin_wait1
-    // 收到ack：fin_wait1 -> fin_wait2
-    // 收到对方的fin报文并发送ack： fin_wait2 -> time_wait
-    // 过了 2MSL ：fin_wait2 -> closed
-    // 各种状态在sender以及receiver上的表现参考tcp_state.hh 和 tcp_state.cc
-    if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV &&
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED && _linger_after_streams_finish &&
-        _time_since_last_segment_received >= 10 * _cfg.rt_timeout) {
-        _is_alive = false;
-        _linger_after_streams_finish = false;
+void TCPConnection::update_linger_timer() {
+    // time_wait 状态下，从最后一次收到报文开始等待 10 * rt_timeout
+    if (_is_alive && _linger_after_streams_finish &&
+        TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV &&
+        TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED) {
+        _linger_timer.start(10 * _cfg.rt_timeout);
+    } else {
+        _linger_timer.stop();
     }
 }
 
@@ -140,22 +264,43 @@ void TCPConnection::send_rst_seg() {
     }
     // 发送一个空的数据报文
     _sender.send_empty_segment();
-    TCPSegment rst_seg = _sender.segments_out().front();
+    TCPSegment rst_seg = move(_sender.segments_out().front());
     _sender.segments_out().pop();
     rst_seg.header().rst = true;
-    _segments_out.push(rst_seg);
+    _segments_out.push(move(rst_seg));
 }
 
 void TCPConnection::send_segments() {
     while (!_sender.segments_out().empty()) {
-        auto seg = _sender.segments_out().front();
+        TCPSegment seg = move(_sender.segments_out().front());
         _sender.segments_out().pop();
         if (_receiver.ackno().has_value()) {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
         }
-        seg.header().win = _receiver.window_size();
-        _segments_out.push(seg);
+        // SYN报文的窗口大小不扩大；其余报文只有双方都同意时才扩大
+        const size_t window = _receiver.window_size() >> (!seg.header().syn && _window_scaling ? _window_shift : 0);
+        seg.header().win = min<size_t>(window, numeric_limits<uint16_t>::max());
+        // SYN报文总是告诉对方自己能接收的MSS
+        // 主动打开时总是提出窗口扩大选项和SACK，被动打开时只有对方提出了才回应
+        if (seg.header().syn) {
+            seg.header().mss = _cfg.mss;
+            const bool active_open = !_receiver.ackno().has_value();
+            if (_cfg.window_scaling && (active_open || _window_scaling)) {
+                seg.header().wscale = _window_shift;
+            }
+            seg.header().sack_permitted = _cfg.sack && (active_open || _sack);
+        } else if (_sack) {
+            // 告诉对方收到了哪些乱序的数据
+            seg.header().sack = _receiver.sack_blocks(TCPHeader::MAX_SACK_BLOCKS);
+        }
+        seg.header().doff = (TCPHeader::LENGTH + seg.header().options_length()) / 4;
+        // 任何带有ack的报文都确认了目前收到的所有数据，不必再延迟发送ack
+        if (seg.header().ack) {
+            _last_ackno_sent = seg.header().ackno;
+            _ack_timer.stop();
+        }
+        _segments_out.push(move(seg));
     }
 }
 
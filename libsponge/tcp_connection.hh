@@ -5,13 +5,38 @@
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
+#include "timing_wheel.hh"
+
+#include <memory>
 
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
+    //! which of the connection's timers a token is for (its low bits; the rest is the connection's id)
+    static constexpr unsigned TIMER_BITS = 2;
+    static constexpr uint64_t RETX_TIMER = 0;
+    static constexpr uint64_t LINGER_TIMER = 1;
+    static constexpr uint64_t ACK_TIMER = 2;
+    static constexpr uint64_t PACING_TIMER = 3;
+
     TCPConfig _cfg;
+
+    //! where the connection's timers are armed: a wheel of its own, or one shared with other connections
+    std::shared_ptr<TimingWheel> _timer_wheel;
+    //! does tick() advance `_timer_wheel`?
+    bool _owns_timer_wheel{false};
+    uint64_t _timer_id;
+
     TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+
+    //! our window scale: how far the window we advertise is shifted right
+    uint8_t _window_shift;
+    //! did both SYNs carry the window scale option?
+    bool _window_scaling{false};
+    //! did both SYNs carry the SACK-permitted option?
+    bool _sack{false};
+    TCPSender _sender{
+        _cfg, _timer_wheel, _timer_id << TIMER_BITS | RETX_TIMER, _timer_id << TIMER_BITS | PACING_TIMER};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -23,7 +48,16 @@ class TCPConnection {
 
     bool _is_alive{true};
 
-    size_t _time_since_last_segment_received{0};
+    //! when (on `_timer_wheel`'s clock) the last segment arrived
+    uint64_t _last_segment_received_at{_timer_wheel->now()};
+
+    //! runs while lingering in TIME_WAIT
+    WheelTimer _linger_timer{_timer_wheel, _timer_id << TIMER_BITS | LINGER_TIMER};
+
+    //! runs while an ACK is being delayed (see TCPConfig::ack_delay)
+    WheelTimer _ack_timer{_timer_wheel, _timer_id << TIMER_BITS | ACK_TIMER};
+    //! the ackno carried by the last segment we sent, if any
+    std::optional<WrappingInt32> _last_ackno_sent{};
 
     // 从_sender中取出报文，设置标记位以及window size，将报文push到_segments_out中
     void send_segments();
@@ -31,6 +65,12 @@ class TCPConnection {
     // 发送一个rst报文
     void send_rst_seg();
 
+    // 根据连接状态启动或停止 time_wait 计时器
+    void update_linger_timer();
+
+    // 收到占用序列号的报文后，立即发送ack，或者启动延迟ack计时器
+    void acknowledge(const TCPSegment &seg, const bool in_order);
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -42,6 +82,10 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, handing over ownership of `data`
+    //! \note With TCPConfig::zero_copy_send, the bytes reach segment payloads without being copied.
+    size_t write(std::string &&data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
@@ -65,6 +109,9 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief Milliseconds of ticks left before the connection has something to do on its own
+    //! (retransmit, send a paced segment or a delayed ACK, or stop lingering), if anything is scheduled
+    std::optional<size_t> time_until_next_timeout() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -76,8 +123,16 @@ class TCPConnection {
     void segment_received(const TCPSegment &seg);
 
     //! Called periodically when time elapses
+    //! \note Does nothing for a connection on a shared TimingWheel: its owner advances the wheel instead,
+    //! and passes each expired token to the timer_expired() of the connection timer_owner() names.
     void tick(const size_t ms_since_last_tick);
 
+    //! Called when one of this connection's timers expires on its TimingWheel
+    void timer_expired(const uint64_t token);
+
+    //! The `id` of the connection that armed the timer with this token
+    static uint64_t timer_owner(const uint64_t token) { return token >> TIMER_BITS; }
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -90,8 +145,11 @@ class TCPConnection {
     bool active() const;
     //!@}
 
-    //! Construct a new connection from a configuration
-    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {}
+    //! Construct a new connection from a configuration, with timers of its own that tick() drives
+    explicit TCPConnection(const TCPConfig &cfg);
+
+    //! Construct a new connection whose timers live on a TimingWheel shared with other connections
+    TCPConnection(const TCPConfig &cfg, std::shared_ptr<TimingWheel> timer_wheel, const uint64_t id);
 
     //! \name construction and destruction
     //! moving is allowed; copying is disallowed; default construction not possible
@@ -1,13 +1,19 @@
 #include "fd_adapter.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <deque>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <utility>
 
 using namespace std;
 
-//! \details This function first attempts to parse a TCP segment from the next UDP
-//! payload recv()d from the socket.
+//! \details This function first attempts to parse a TCP segment from the UDP payload.
 //!
 //! If this succeeds, it then checks that the received segment is related to the
 //! current connection. When a TCP connection has been established, this means
@@ -18,24 +24,22 @@ using namespace std;
 //! `_listen` flag and calls calls connect() on the underlying UDP socket, with
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
-
+optional<TCPSegment> TCPOverUDPSocketAdapter::accept(const Address &source, Buffer payload) {
     // is it for us?
-    if (not listening() and (datagram.source_address != config().destination)) {
+    if (not listening() and (source != config().destination)) {
         return {};
     }
 
     // is the payload a valid TCP segment?
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(payload), 0)) {
         return {};
     }
 
     // should we target this source in all future replies?
     if (listening()) {
         if (seg.header().syn and not seg.header().rst) {
-            config_mutable().destination = datagram.source_address;
+            config_mutable().destination = source;
             set_listening(false);
         } else {
             return {};
@@ -45,12 +49,180 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     return seg;
 }
 
+//! \details Once per adapter, and only with FdAdapterConfig::udp_offload. If the kernel refuses either option,
+//! the adapter goes on without it.
+void TCPOverUDPSocketAdapter::try_offload() {
+    if (_offload_tried or not config().udp_offload) {
+        return;
+    }
+    _offload_tried = true;
+    try {
+        _sock.set_gso_size(0);
+        _gso = true;
+    } catch (const unix_error &e) {
+        cerr << "Warning: no UDP GSO, sending one datagram at a time (" << e.what() << ")\n";
+    }
+    try {
+        _sock.set_gro(true);
+        _gro = true;
+    } catch (const unix_error &e) {
+        cerr << "Warning: no UDP GRO, receiving one datagram at a time (" << e.what() << ")\n";
+    }
+}
+
+//! \details Each `gro_size` bytes of a merged payload (the last piece may be shorter) is a datagram of its own,
+//! see accept(). The pieces share `payload`'s storage.
+//! \param[in] source the sender of the payload
+//! \param[in] payload the UDP payload
+//! \param[in] gro_size the size of each datagram merged into `payload`, or 0 if it is one datagram
+//! \param[out] segs the vector to append the segments to
+void TCPOverUDPSocketAdapter::accept_merged(const Address &source,
+                                            Buffer payload,
+                                            const size_t gro_size,
+                                            vector<TCPSegment> &segs) {
+    if (gro_size == 0) {
+        auto seg = accept(source, move(payload));
+        if (seg) {
+            segs.push_back(move(seg.value()));
+        }
+        return;
+    }
+    for (size_t offset = 0; offset < payload.size(); offset += gro_size) {
+        Buffer piece = payload;
+        piece.remove_prefix(offset);
+        piece.remove_suffix(piece.size() - min(piece.size(), gro_size));
+        auto seg = accept(source, move(piece));
+        if (seg) {
+            segs.push_back(move(seg.value()));
+        }
+    }
+}
+
+//! \details Reads the next UDP payload recv()d from the socket, see accept(). With UDP GRO, the other segments of
+//! a merged payload are returned by the following calls, without reading the socket (see unread()).
+//! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
+optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
+    try_offload();
+    if (_unread.empty()) {
+        auto datagram = _sock.recv();
+        if (datagram.gro_size == 0) {
+            return accept(datagram.source_address, move(datagram.payload));
+        }
+        vector<TCPSegment> segs;
+        accept_merged(datagram.source_address, move(datagram.payload), datagram.gro_size, segs);
+        move(segs.begin(), segs.end(), back_inserter(_unread));
+    }
+    if (_unread.empty()) {
+        return {};
+    }
+    auto seg = move(_unread.front());
+    _unread.pop_front();
+    return seg;
+}
+
+//! \details Waits for the first datagram (if `wait`), then takes the ones that have already arrived behind it, with one
+//! [recvmmsg(2)](\ref man2::recvmmsg). Invalid and unrelated payloads are skipped, as with read(). With UDP GRO,
+//! each payload may hold many datagrams, so more than `max` segments may be appended. If read() has left segments
+//! unread(), this appends those instead, without reading the socket.
+//! \param[out] segs the vector to append the segments to
+//! \param[in] max the most UDP payloads to read
+//! \param[in] wait whether to wait for the first UDP payload
+//! \returns the number of UDP payloads read, valid or not
+size_t TCPOverUDPSocketAdapter::read_batch(vector<TCPSegment> &segs, const size_t max, const bool wait) {
+    try_offload();
+    if (not _unread.empty()) {
+        move(_unread.begin(), _unread.end(), back_inserter(segs));
+        _unread.clear();
+        return 0;
+    }
+    if (_batch.size() < max) {
+        _batch.resize(max, {{nullptr, 0}, {}});
+    }
+    const size_t n = _sock.recv_batch(_batch, max, wait);
+    for (size_t i = 0; i < n; i++) {
+        // copy the payload out, so that its buffer can take the next batch
+        accept_merged(_batch[i].source_address, string(_batch[i].payload), _batch[i].gro_size, segs);
+    }
+    return n;
+}
+
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
-//! \param[in] seg is the TCP segment to write
+//! \param[in] seg is the TCP segment to write; a super-segment goes out as one datagram per piece
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (seg.gso_size() == 0) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    for (const auto &piece : seg.split()) {
+        _sock.sendto(config().destination, piece.serialize(0));
+    }
+}
+
+//! Serialize TCP segments and send them as UDP datagrams with [sendmmsg(2)](\ref man2::sendmmsg).
+//! \details With UDP GSO, each run of datagrams of one size (the last may be shorter, as when cutting a
+//! super-segment) goes to the kernel as one payload, which it cuts up again. If the kernel rejects such a
+//! payload, the adapter warns, stops using GSO, and sends the datagrams that hadn't gone out yet one by one.
+//! \param[in] segs the TCP segments to write; a super-segment goes out as one datagram per piece
+void TCPOverUDPSocketAdapter::write_batch(vector<TCPSegment> &segs) {
+    try_offload();
+    vector<BufferList> datagrams;
+    datagrams.reserve(segs.size());
+    for (auto &seg : segs) {
+        seg.header().sport = config().source.port();
+        seg.header().dport = config().destination.port();
+        if (seg.gso_size() == 0) {
+            datagrams.push_back(seg.serialize(0));
+            continue;
+        }
+        for (const auto &piece : seg.split()) {
+            datagrams.push_back(piece.serialize(0));
+        }
+    }
+
+    size_t unsent = 0;
+    if (_gso) {
+        vector<BufferViewList> payloads;
+        vector<uint16_t> gso_sizes;
+        vector<size_t> firsts;  // index in `datagrams` of each payload's first datagram
+        for (size_t i = 0; i < datagrams.size();) {
+            const size_t size = datagrams[i].size();
+            deque<string_view> views;
+            size_t n = 0, total = 0;
+            while (i + n < datagrams.size() and
+                   (n == 0 or (n < UDPSocket::MAX_GSO_SEGMENTS and datagrams[i + n].size() <= size and
+                               total + datagrams[i + n].size() <= UDPSocket::MAX_PAYLOAD))) {
+                const BufferList &datagram = datagrams[i + n];
+                for (const auto &buffer : datagram.buffers()) {
+                    views.push_back(buffer);
+                }
+                total += datagram.size();
+                n++;
+                if (datagram.size() < size) {
+                    break;
+                }
+            }
+            payloads.emplace_back(move(views));
+            gso_sizes.push_back(n > 1 ? size : 0);
+            firsts.push_back(i);
+            i += n;
+        }
+        try {
+            _sock.sendto_batch(config().destination, payloads, gso_sizes);
+            return;
+        } catch (const UDPSocket::batch_send_error &e) {
+            // only these mean the kernel (or the device) can't do UDP_SEGMENT; anything else is the caller's
+            const int error = e.code().value();
+            if (error != EINVAL and error != EIO and error != EOPNOTSUPP) {
+                throw;
+            }
+            cerr << "Warning: UDP GSO failed, sending one datagram at a time (" << e.what() << ")\n";
+            _gso = false;
+            unsent = firsts[e.sent];
+        }
+    }
+    _sock.sendto_batch(config().destination, {datagrams.begin() + unsent, datagrams.end()});
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
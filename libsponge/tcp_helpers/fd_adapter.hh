@@ -8,8 +8,10 @@
 #include "tcp_header.hh"
 #include "tcp_segment.hh"
 
+#include <deque>
 #include <optional>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -47,16 +49,49 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
 
+    //! Storage for read_batch(), kept between calls so that each datagram's buffer is allocated once
+    std::vector<UDPSocket::received_datagram> _batch{};
+
+    //! Segments read() has taken from a merged datagram but not yet returned
+    std::deque<TCPSegment> _unread{};
+
+    bool _offload_tried = false;  //!< Has try_offload() asked the kernel for GSO and GRO?
+    bool _gso = false;            //!< Does the kernel cut runs of equal-sized datagrams for us?
+    bool _gro = false;            //!< Does the kernel merge arriving datagrams?
+
+    //! Turn on the kernel's UDP GSO and GRO the first time they're wanted, keeping whichever it accepts
+    void try_offload();
+
+    //! Parse a TCP segment related to the current connection from a UDP payload received from `source`
+    std::optional<TCPSegment> accept(const Address &source, Buffer payload);
+
+    //! Parse the TCP segments in a UDP payload that UDP GRO may have merged, appending them to `segs`
+    void accept_merged(const Address &source, Buffer payload, const size_t gro_size, std::vector<TCPSegment> &segs);
+
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
 
-    //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
+    //! \brief Attempts to read and return a TCP segment related to the current connection from a UDP payload
+    //! \details With UDP GRO, one payload can hold many segments: read() returns the first, and keeps the rest
+    //! for the following calls, which return them without reading the socket. A caller that waits for the socket
+    //! to become readable (e.g., with an EventLoop) must call read() again while unread() is nonzero, or those
+    //! segments will wait for the next datagram to arrive. read_batch() returns all of them at once.
     std::optional<TCPSegment> read();
 
+    //! The number of segments that read() has taken off the socket but not yet returned
+    size_t unread() const { return _unread.size(); }
+
+    //! Reads up to `max` UDP payloads with one syscall, appending the TCP segments related to the current
+    //! connection to `segs`
+    size_t read_batch(std::vector<TCPSegment> &segs, const size_t max, const bool wait = true);
+
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Writes each of `segs` into a UDP payload, with as few syscalls as possible
+    void write_batch(std::vector<TCPSegment> &segs);
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -8,15 +8,25 @@
 
 using namespace std;
 
+//! Offsets of the TTL and checksum fields in a serialized IPv4 header
+static constexpr size_t TTL_OFFSET = 8;
+static constexpr size_t CKSUM_OFFSET = 10;
+
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
-    _header.parse(p);
+    _serialized_header = {};
+    const auto result = _header.parse(p);
     _payload = p.buffer();
 
     if (_payload.size() != _header.payload_length()) {
         return ParseResult::PacketTooShort;
     }
 
+    if (result == ParseResult::NoError and not p.error()) {
+        _serialized_header = buffer;
+        _serialized_header.remove_suffix(_payload.size());
+    }
+
     return p.get_error();
 }
 
@@ -25,17 +35,47 @@ BufferList IPv4Datagram::serialize() const {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
+    BufferList ret;
+    if (_serialized_header.size() > 0) {
+        ret.append(_serialized_header);
+        ret.append(_payload);
+        return ret;
+    }
+
     IPv4Header header_out = _header;
     header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    string header_bytes = header_out.serialize();
 
-    // calculate checksum -- taken over header only
+    // calculate checksum -- taken over header only -- and patch it into the serialized header
     InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    check.add(header_bytes);
+    const uint16_t cksum = check.value();
+    header_bytes[CKSUM_OFFSET] = static_cast<char>(cksum >> 8);
+    header_bytes[CKSUM_OFFSET + 1] = static_cast<char>(cksum & 0xff);
 
-    BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(move(header_bytes));
     ret.append(_payload);
     return ret;
 }
+
+//! \details TTL shares a 16-bit word with the protocol field, so the checksum is adjusted
+//! for that word only (RFC 1624). If the parsed header bytes are still
+//! valid, a copy of them is patched (TTL and checksum only) so serialize() can reuse it.
+void IPv4Datagram::decrement_ttl() {
+    if (_header.ttl == 0) {
+        throw runtime_error("IPv4Datagram::decrement_ttl: TTL is already zero");
+    }
+
+    const uint16_t old_word = (_header.ttl << 8) | _header.proto;
+    _header.ttl--;
+    const uint16_t new_word = (_header.ttl << 8) | _header.proto;
+    _header.cksum = InternetChecksum::adjust(_header.cksum, old_word, new_word);
+
+    if (_serialized_header.size() > 0) {
+        string patched = _serialized_header.copy();
+        patched[TTL_OFFSET] = static_cast<char>(_header.ttl);
+        patched[CKSUM_OFFSET] = static_cast<char>(_header.cksum >> 8);
+        patched[CKSUM_OFFSET + 1] = static_cast<char>(_header.cksum & 0xff);
+        _serialized_header = Buffer{move(patched)};
+    }
+}
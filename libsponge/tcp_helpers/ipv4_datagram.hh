@@ -10,17 +10,30 @@ class IPv4Datagram {
     IPv4Header _header{};
     BufferList _payload{};
 
+    //! The header bytes as parsed (and patched by decrement_ttl()); empty once the header may have been modified
+    Buffer _serialized_header{};
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the segment to a string
+    //! \note Reuses the parsed header bytes if the header has only been changed by decrement_ttl()
     BufferList serialize() const;
 
+    //! \brief Forwarding fast path: decrement the TTL (which must be nonzero) and update the
+    //! checksum incrementally, without re-serializing the header
+    void decrement_ttl();
+
     //! \name Accessors
     //!@{
     const IPv4Header &header() const { return _header; }
-    IPv4Header &header() { return _header; }
+
+    //! \note Mutable access discards the parsed header bytes, so the next serialize() rebuilds them
+    IPv4Header &header() {
+        _serialized_header = {};
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
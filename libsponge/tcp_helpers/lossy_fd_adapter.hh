@@ -6,9 +6,11 @@
 #include "tcp_segment.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <optional>
 #include <random>
 #include <utility>
+#include <vector>
 
 //! An adapter class that adds random dropping behavior to an FD adapter
 template <typename AdapterT>
@@ -47,15 +49,49 @@ class LossyFdAdapter {
         return ret;
     }
 
+    //! \brief Read a batch from the underlying AdapterT instance, potentially dropping each segment read
+    //! \param[out] segs the vector to append the segments that were not dropped to
+    //! \param[in] max the most datagrams to read
+    //! \param[in] wait whether to wait for the first datagram
+    //! \returns the number of datagrams the underlying AdapterT read, dropped or not
+    size_t read_batch(std::vector<TCPSegment> &segs, const size_t max, const bool wait = true) {
+        const size_t first = segs.size();
+        const size_t read = _adapter.read_batch(segs, max, wait);
+        const auto dropped = [&](const TCPSegment &) { return _should_drop(false); };
+        segs.erase(std::remove_if(segs.begin() + first, segs.end(), dropped), segs.end());
+        return read;
+    }
+
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
-    //! \param[in] seg is the packet to either write or drop
+    //! \param[in] seg is the packet to either write or drop; each piece of a super-segment is dropped or not
+    //!            on its own
     void write(TCPSegment &seg) {
+        if (seg.gso_size() > 0) {
+            for (auto &piece : seg.split()) {
+                write(piece);
+            }
+            return;
+        }
         if (_should_drop(true)) {
             return;
         }
         return _adapter.write(seg);
     }
 
+    //! \brief Write a batch to the underlying AdapterT instance, potentially dropping each datagram to be written
+    //! \param[in] segs the packets to either write or drop; as with write(), super-segments are dropped piece by piece
+    void write_batch(std::vector<TCPSegment> &segs) {
+        std::vector<TCPSegment> kept;
+        for (const auto &seg : segs) {
+            for (auto &piece : seg.split()) {
+                if (not _should_drop(true)) {
+                    kept.push_back(std::move(piece));
+                }
+            }
+        }
+        _adapter.write_batch(kept);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -12,13 +12,44 @@
 class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Default MSS: conservative max payload size for real Internet
+    static constexpr size_t MAX_GSO_SIZE = 65536;      //!< Most payload one super-segment carries (see gso)
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr unsigned RTO_MIN_DFLT = 200;      //!< Default lower bound of an adaptive RTO, in milliseconds
+    static constexpr unsigned RTO_MAX_DFLT = 60000;    //!< Default upper bound of an adaptive RTO, in milliseconds
+
+    //! Congestion control algorithm for the sender (see CongestionControl)
+    enum class Congestion {
+        None,     //!< Send as much as the receiver's window allows
+        NewReno,  //!< Halve the congestion window on loss, grow it by one segment per round trip
+        Cubic     //!< Regrow the congestion window along a cubic curve after a loss
+    };
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                //!< Derive the RTO from measured round-trip times (RFC 6298)
+    unsigned rto_min = RTO_MIN_DFLT;          //!< Lower bound of an adaptive RTO, in milliseconds
+    unsigned rto_max = RTO_MAX_DFLT;          //!< Upper bound of an adaptive RTO (and its backoff), in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    uint16_t mss = MAX_PAYLOAD_SIZE;          //!< Largest payload to send or receive, offered in the SYN's MSS option
+    bool zero_copy_send = false;              //!< Keep written data as refcounted chunks in the outbound stream
+    bool window_scaling = true;               //!< Offer the window scale option, so windows can exceed 64 KiB
+    bool sack = true;                         //!< Offer selective acknowledgments (SACK)
+    //! Delay the ACK of in-order data by up to this many milliseconds, unless a second full segment
+    //! arrives first (0: acknowledge every segment right away)
+    uint16_t ack_delay = 0;
+    bool pacing = false;  //!< Spread the sender's segments out in time instead of sending each window in a burst
+    //! Pacing rate in bytes per millisecond (0: estimate it from the window and the smoothed RTT)
+    size_t pacing_rate = 0;
+    //! Queue new data as super-segments of up to MAX_GSO_SIZE bytes, which the adapter cuts into
+    //! segments of at most `mss` bytes (see TCPSegment::split())
+    bool gso = false;
+    //! Read every segment already waiting at the adapter, and merge runs of in-order segments into one
+    //! before TCPConnection sees them (see TCPSegment::coalesce())
+    bool gro = false;
+    //! How the sender limits the data it has in flight
+    Congestion congestion_control = Congestion::None;
     std::optional<WrappingInt32> fixed_isn{};
 };
 
@@ -30,6 +61,8 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    bool udp_offload = false;  //!< Use the kernel's UDP GSO and GRO, where it has them (for TCPOverUDPSocketAdapter)
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
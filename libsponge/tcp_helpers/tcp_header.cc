@@ -1,9 +1,29 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! \name TCP option kinds
+//!@{
+static constexpr uint8_t OPT_EOL = 0;     //!< end of option list
+static constexpr uint8_t OPT_NOP = 1;     //!< no-operation (padding between options)
+static constexpr uint8_t OPT_MSS = 2;             //!< maximum segment size
+static constexpr uint8_t OPT_WSCALE = 3;          //!< window scale
+static constexpr uint8_t OPT_SACK_PERMITTED = 4;  //!< SACK permitted
+static constexpr uint8_t OPT_SACK = 5;            //!< SACK blocks
+//!@}
+
+//! Bytes of the SACK option (two NOPs in front) with `blocks` blocks
+static size_t sack_option_length(const size_t blocks) { return blocks == 0 ? 0 : 4 + 8 * blocks; }
+
+size_t TCPHeader::options_length() const {
+    // MSS, NOP + window scale, NOP + NOP + SACK permitted, NOP + NOP + SACK
+    return (mss.has_value() ? 4 : 0) + (wscale.has_value() ? 4 : 0) + (sack_permitted ? 4 : 0) +
+           sack_option_length(sack.size());
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -14,6 +34,8 @@ using namespace std;
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
+//!
+//! Options the header doesn't understand, or that are malformed, are ignored.
 ParseResult TCPHeader::parse(NetParser &p) {
     sport = p.u16();                 // source port
     dport = p.u16();                 // destination port
@@ -37,13 +59,49 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
+    // the options fill the rest of the header
+    const Buffer options_buf = p.buffer();
     p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
 
     if (p.error()) {
         return p.get_error();
     }
 
+    mss.reset();
+    wscale.reset();
+    sack_permitted = false;
+    sack.clear();
+    const string_view options = options_buf.str().substr(0, doff * 4 - TCPHeader::LENGTH);
+    for (size_t i = 0; i < options.size();) {
+        const uint8_t kind = options[i];
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            i++;
+            continue;
+        }
+        // every other option has a length byte that counts the kind and length bytes too
+        const uint8_t len = i + 1 < options.size() ? options[i + 1] : 0;
+        if (len < 2 or i + len > options.size()) {
+            break;
+        }
+        if (kind == OPT_MSS and len == 4) {
+            mss = uint16_t(uint8_t(options[i + 2]) << 8 | uint8_t(options[i + 3]));
+        } else if (kind == OPT_WSCALE and len == 3) {
+            wscale = min<uint8_t>(options[i + 2], MAX_WSCALE);
+        } else if (kind == OPT_SACK_PERMITTED and len == 2) {
+            sack_permitted = true;
+        } else if (kind == OPT_SACK and len > 2 and (len - 2) % 8 == 0) {
+            NetParser blocks{string{options.substr(i + 2, len - 2)}};
+            for (size_t n = 0; n < size_t(len - 2) / 8; n++) {
+                const WrappingInt32 left{blocks.u32()};
+                sack.push_back({left, WrappingInt32{blocks.u32()}});
+            }
+        }
+        i += len;
+    }
+
     return ParseResult::NoError;
 }
 
@@ -72,7 +130,38 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options, as far as doff leaves room for them
+    if (mss.has_value() and ret.size() + 4 <= 4 * doff) {
+        NetUnparser::u8(ret, OPT_MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, mss.value());
+    }
+    if (wscale.has_value() and ret.size() + 4 <= 4 * doff) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_WSCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, wscale.value());
+    }
+    if (sack_permitted and ret.size() + 4 <= 4 * doff) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+    const size_t sack_room = 4 * doff > ret.size() + 4 ? 4 * doff - ret.size() - 4 : 0;
+    const size_t sack_blocks = min({sack.size(), MAX_SACK_BLOCKS, sack_room / 8});
+    if (sack_blocks > 0) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK);
+        NetUnparser::u8(ret, 2 + 8 * sack_blocks);
+        for (size_t n = 0; n < sack_blocks; n++) {
+            NetUnparser::u32(ret, sack[n].left.raw_value());
+            NetUnparser::u32(ret, sack[n].right.raw_value());
+        }
+    }
+
+    ret.resize(4 * doff);  // expand header to advertised size (padding with OPT_EOL)
 
     return ret;
 }
@@ -90,13 +179,35 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP MSS: " << +mss.value() << '\n';
+    }
+    if (wscale.has_value()) {
+        ss << "TCP wscale: " << +wscale.value() << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (const auto &block : sack) {
+        ss << "TCP SACK: " << block.left << "-" << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (wscale.has_value()) {
+        ss << ",wscale=" << +wscale.value();
+    }
+    for (const auto &block : sack) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +215,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && wscale == other.wscale && sack_permitted == other.sack_permitted &&
+           sack == other.sack;
 }
@@ -4,10 +4,23 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only MSS, window scale and SACK are understood; others are skipped when parsing
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;          //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr uint8_t MAX_WSCALE = 14;     //!< Largest window scale shift count (RFC 7323)
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< Most SACK blocks that fit in the options (RFC 2018)
+
+    //! \brief A SACK block: the receiver holds the sequence numbers [left, right)
+    struct SackBlock {
+        WrappingInt32 left{0};   //!< first sequence number of the block
+        WrappingInt32 right{0};  //!< sequence number just past the block
+
+        bool operator==(const SackBlock &other) const { return left == other.left && right == other.right; }
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,6 +63,19 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //! \note `doff` sets the header's length, so it must leave room for the options to be serialized
+    //! (see options_length())
+    //!@{
+    std::optional<uint16_t> mss{};    //!< maximum segment size the sender will accept (RFC 793), only on SYN segments
+    std::optional<uint8_t> wscale{};  //!< window scale shift count (RFC 7323), only on SYN segments
+    bool sack_permitted = false;      //!< SACK-permitted (RFC 2018), only on SYN segments
+    std::vector<SackBlock> sack{};    //!< SACK blocks (RFC 2018), at most MAX_SACK_BLOCKS
+    //!@}
+
+    //! Number of bytes the options take up in the header, a multiple of four
+    size_t options_length() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
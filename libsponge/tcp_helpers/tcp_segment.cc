@@ -3,6 +3,8 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <string>
 #include <variant>
 
 using namespace std;
@@ -22,6 +24,71 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     return p.get_error();
 }
 
+vector<TCPSegment> TCPSegment::split() const {
+    if (_gso_size == 0 or _payload.size() <= _gso_size) {
+        TCPSegment whole = *this;
+        whole._gso_size = 0;
+        return {whole};
+    }
+
+    vector<TCPSegment> pieces;
+    pieces.reserve((_payload.size() + _gso_size - 1) / _gso_size);
+    for (size_t offset = 0; offset < _payload.size(); offset += _gso_size) {
+        const size_t end = min(offset + _gso_size, _payload.size());
+        TCPSegment piece;
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + static_cast<uint32_t>(offset + (offset > 0 and _header.syn));
+        piece._header.syn = _header.syn and offset == 0;
+        piece._header.fin = _header.fin and end == _payload.size();
+        piece._header.psh = _header.psh and end == _payload.size();
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(_payload.size() - end);
+        pieces.push_back(move(piece));
+    }
+    return pieces;
+}
+
+//! Can `next` be appended to `prev` by TCPSegment::coalesce()?
+static bool coalescible(const TCPSegment &prev, const TCPSegment &next) {
+    const TCPHeader &a = prev.header(), &b = next.header();
+    return not(a.syn or a.fin or a.rst or a.urg or b.syn or b.rst or b.urg) and prev.payload().size() > 0 and
+           next.payload().size() > 0 and b.seqno == a.seqno + static_cast<uint32_t>(prev.payload().size()) and
+           a.sport == b.sport and a.dport == b.dport and a.ack == b.ack and a.ackno == b.ackno and a.win == b.win and
+           a.sack == b.sack;
+}
+
+vector<TCPSegment> TCPSegment::coalesce(vector<TCPSegment> &&segments, const size_t max_payload) {
+    vector<TCPSegment> merged;
+    merged.reserve(segments.size());
+    for (size_t begin = 0, end = 0; begin < segments.size(); begin = end) {
+        size_t size = segments[begin]._payload.size();
+        for (end = begin + 1; end < segments.size() and coalescible(segments[end - 1], segments[end]) and
+                              size + segments[end]._payload.size() <= max_payload;
+             end++) {
+            size += segments[end]._payload.size();
+        }
+        if (end == begin + 1) {
+            merged.push_back(move(segments[begin]));
+            continue;
+        }
+
+        // copy the run's payloads once, into one buffer
+        string payload;
+        payload.reserve(size);
+        TCPSegment seg;
+        seg._header = segments[begin]._header;
+        for (size_t i = begin; i < end; i++) {
+            payload.append(segments[i]._payload.str());
+            seg._header.psh |= segments[i]._header.psh;
+        }
+        seg._header.fin = segments[end - 1]._header.fin;
+        seg._payload = Buffer{move(payload)};
+        merged.push_back(move(seg));
+    }
+    return merged;
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
@@ -5,12 +5,14 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    size_t _gso_size{0};
 
   public:
     //! \brief Parse the segment from a string
@@ -26,8 +28,24 @@ class TCPSegment {
 
     const Buffer &payload() const { return _payload; }
     Buffer &payload() { return _payload; }
+
+    //! \brief If nonzero, this is a super-segment, to be sent as segments of at most this many bytes of payload
+    //! (see split())
+    size_t gso_size() const { return _gso_size; }
+    size_t &gso_size() { return _gso_size; }
     //!@}
 
+    //! \brief The segments a super-segment stands for, each with a copy of its header and a slice of its payload
+    //! \details The seqnos follow on from each other; only the first keeps SYN, and only the last keeps FIN and
+    //! PSH. A segment that is not a super-segment (or fits in one piece) comes back as it is.
+    std::vector<TCPSegment> split() const;
+
+    //! \brief Merge each run of consecutive in-order segments into one segment, the reverse of split()
+    //! \details Segments of a run carry data, follow on from each other in sequence space, and agree on ports,
+    //! ACK, window and SACK blocks; none has SYN, RST or URG, and only the last may have FIN. The merged segment
+    //! keeps the first one's header, with FIN from the last and PSH from any, and at most `max_payload` bytes.
+    static std::vector<TCPSegment> coalesce(std::vector<TCPSegment> &&segments, const size_t max_payload);
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -18,14 +19,28 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_arm_timeout_timer() {
+    if (_timeout_timer.has_value()) {
+        _eventloop.cancel_timer(_timeout_timer.value());
+        _timeout_timer.reset();
+    }
+
+    const auto timeout = _tcp.value().active() ? _tcp.value().time_until_next_timeout() : nullopt;
+    if (timeout.has_value()) {
+        // the timer only needs to wake up the loop, which ticks the TCPConnection after every event
+        _timeout_timer = _eventloop.add_timer(timeout.value(), [] {});
+    }
+}
 
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // sleep until an fd is ready or the TCPConnection's next timeout is due
+        _arm_timeout_timer();
+        auto ret = _eventloop.wait_next_event(-1);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -46,7 +61,8 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _abort_event(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
     _thread_data.set_blocking(false);
 }
 
@@ -72,13 +88,26 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     // 4) Outbound segment generated by TCP (needs to be
     //    given to underlying datagram socket)
 
-    // rule 1: read from filtered packet stream and dump into TCPConnection
+    // rule 1: read a batch from filtered packet stream and dump into TCPConnection
+    // (with gro, keep reading, without waiting, while a batch comes back full, as more has likely arrived behind
+    // it, and hand each in-order run over as one segment)
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
-                        [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                        [&, gro = config.gro] {
+                            vector<TCPSegment> segs;
+                            size_t read = 0, batch = 0;
+                            do {
+                                batch = _datagram_adapter.read_batch(segs, MAX_BATCH, read == 0);
+                                read += batch;
+                            } while (gro and batch == MAX_BATCH and read < MAX_GRO_BATCH);
+                            if (gro) {
+                                segs = TCPSegment::coalesce(move(segs), TCPConfig::MAX_GSO_SIZE);
+                            }
+                            for (auto &seg : segs) {
+                                if (not _tcp->active()) {
+                                    break;
+                                }
+                                _tcp->segment_received(move(seg));
                             }
 
                             // debugging output:
@@ -96,7 +125,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -129,8 +158,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_output_views(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -150,16 +178,26 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                    ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
         });
 
-    // rule 4: read outbound segments from TCPConnection and send as datagrams
+    // rule 4: read outbound segments from TCPConnection and send them as datagrams, in one batch
     _eventloop.add_rule(_datagram_adapter,
                         Direction::Out,
                         [&] {
+                            vector<TCPSegment> segs;
+                            segs.reserve(_tcp->segments_out().size());
                             while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
+                                segs.push_back(move(_tcp->segments_out().front()));
                                 _tcp->segments_out().pop();
                             }
+                            _datagram_adapter.write_batch(segs);
                         },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: wake up when the owner sets _abort (only needed while the other rules might still have work)
+    _eventloop.add_rule(
+        _abort_event,
+        Direction::In,
+        [&] { _abort_event.read(sizeof(uint64_t)); },
+        [&] { return _tcp->active() or not _inbound_shutdown; });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -183,6 +221,8 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            const uint64_t one = 1;
+            SystemCall("write", ::write(_abort_event.fd_num(), &one, sizeof(one)));
             _tcp_thread.join();
         }
     } catch (const exception &e) {
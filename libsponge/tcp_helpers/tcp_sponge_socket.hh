@@ -28,6 +28,12 @@ class TCPSpongeSocket : public LocalStreamSocket {
     AdaptT _datagram_adapter;
 
   private:
+    //! Most datagrams read from the adapter per batch
+    static constexpr size_t MAX_BATCH = 64;
+
+    //! Most datagrams read per wakeup when coalescing them (TCPConfig::gro)
+    static constexpr size_t MAX_GRO_BATCH = 4 * MAX_BATCH;
+
     //! Set up the TCPConnection and the event loop
     void _initialize_TCP(const TCPConfig &config);
 
@@ -37,6 +43,15 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
+    //! Timer that wakes the eventloop when the TCPConnection's next timeout (e.g. retransmission) is due
+    std::optional<EventLoop::TimerID> _timeout_timer{};
+
+    //! (Re)arm _timeout_timer for the TCPConnection's next timeout
+    void _arm_timeout_timer();
+
+    //! Readable when the owner has set _abort, to wake the TCPConnection thread
+    FileDescriptor _abort_event;
+
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
@@ -36,18 +36,46 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     return {};
 }
 
+//! \param[out] segs the vector to append the segment to
+//! \param[in] wait whether to read at all, as reading the device might wait for a frame
+//! \returns the number of frames read: 1, or 0 if not told to `wait`
+//! \note A TAP device gives one frame per syscall, so this reads just one
+size_t TCPOverIPv4OverEthernetAdapter::read_batch(vector<TCPSegment> &segs, const size_t, const bool wait) {
+    if (not wait) {
+        return 0;
+    }
+    auto seg = read();
+    if (seg) {
+        segs.push_back(move(seg.value()));
+    }
+    return 1;
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
     _interface.tick(ms_since_last_tick);
     send_pending();
 }
 
-//! \param[in] seg the TCPSegment to send
+//! \param[in] seg the TCPSegment to send; a super-segment goes out as one datagram per piece
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    if (seg.gso_size() == 0) {
+        _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    } else {
+        for (auto &piece : seg.split()) {
+            _interface.send_datagram(wrap_tcp_in_ip(piece), _next_hop);
+        }
+    }
     send_pending();
 }
 
+//! \param[in] segs the TCPSegments to send
+void TCPOverIPv4OverEthernetAdapter::write_batch(vector<TCPSegment> &segs) {
+    for (auto &seg : segs) {
+        write(seg);
+    }
+}
+
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
     while (not _interface.frames_out().empty()) {
         _tap.write(_interface.frames_out().front().serialize());
@@ -8,6 +8,7 @@
 #include <optional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
@@ -27,8 +28,36 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Reads one IPv4 datagram (a TUN device gives one per syscall), appending its TCP segment to `segs`
+    //! \returns the number of datagrams read: 1, or 0 if told not to `wait` (reading the device might)
+    size_t read_batch(std::vector<TCPSegment> &segs, const size_t, const bool wait = true) {
+        if (not wait) {
+            return 0;
+        }
+        auto seg = read();
+        if (seg) {
+            segs.push_back(std::move(seg.value()));
+        }
+        return 1;
+    }
+
+    //! Creates an IPv4 datagram from a TCP segment (or each piece of a super-segment) and writes it to the TUN device
+    void write(TCPSegment &seg) {
+        if (seg.gso_size() == 0) {
+            _tun.write(wrap_tcp_in_ip(seg).serialize());
+            return;
+        }
+        for (auto &piece : seg.split()) {
+            _tun.write(wrap_tcp_in_ip(piece).serialize());
+        }
+    }
+
+    //! Writes each of `segs` to the TUN device
+    void write_batch(std::vector<TCPSegment> &segs) {
+        for (auto &seg : segs) {
+            write(seg);
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -60,9 +89,15 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
+    //! Reads one Ethernet frame, appending the TCP segment it carries (if any) to `segs`
+    size_t read_batch(std::vector<TCPSegment> &segs, const size_t max, const bool wait = true);
+
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
+    //! Sends each of `segs`, as write() does
+    void write_batch(std::vector<TCPSegment> &segs);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
@@ -23,7 +23,8 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     uint64_t checkpoint = _reassembler.stream_out().bytes_written();
     // 对于stream_idx，应该为abs_seq - 1,
     size_t stream_idx = unwrap(seqno, _isn, checkpoint) - 1;
-    _reassembler.push_substring(seg.payload().copy(), stream_idx, _got_syn && seg.header().fin);
+    _last_segment_idx = stream_idx;
+    _reassembler.push_substring(seg.payload(), stream_idx, _got_syn && seg.header().fin);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -39,6 +40,27 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
     return wrap(ackno, _isn);
 }
 
+vector<TCPHeader::SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<TCPHeader::SackBlock> blocks;
+    if (!_got_syn || max_blocks == 0) {
+        return blocks;
+    }
+    // stream index + 1 = absolute seqno
+    const auto ranges = _reassembler.unassembled_ranges();
+    for (const auto &[start, end] : ranges) {
+        const TCPHeader::SackBlock block{wrap(start + 1, _isn), wrap(end + 1, _isn)};
+        if (start <= _last_segment_idx && _last_segment_idx < end) {
+            blocks.insert(blocks.begin(), block);
+        } else {
+            blocks.push_back(block);
+        }
+    }
+    if (blocks.size() > max_blocks) {
+        blocks.resize(max_blocks);
+    }
+    return blocks;
+}
+
 size_t TCPReceiver::window_size() const {
     // window_size 应该是 first unassembled 到 first unaccept 之间的距离
     // size_t first_unassemble = _reassembler.stream_out().bytes_written();
@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -21,13 +22,19 @@ class TCPReceiver {
     size_t _capacity;
     WrappingInt32 _isn;  // the Initial Sequence Number
     bool _got_syn;       // Has SYN been received?
+    //! stream index of the payload of the last segment received, which SACK reports first
+    uint64_t _last_segment_idx{0};
 
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), _isn(0), _got_syn(false) {}
+    //! \note The inbound stream keeps refcounted slices of the received payloads, so in-order
+    //! data reaches it without being copied. Payloads that are a small part of their datagram's
+    //! storage are copied, so the storage held stays within about twice `capacity`.
+    TCPReceiver(const size_t capacity)
+        : _reassembler(capacity, ByteStream::Storage::Chunked), _capacity(capacity), _isn(0), _got_syn(false) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -50,6 +57,10 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks (RFC 2018) for the data held beyond the ackno, at most `max_blocks` of them
+    //! \details The block holding the most recently received segment comes first, then the rest in order.
+    std::vector<TCPHeader::SackBlock> sack_blocks(const size_t max_blocks) const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
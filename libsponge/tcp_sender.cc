@@ -2,6 +2,8 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 
@@ -18,19 +20,54 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
+//! \param[in] storage how the outgoing byte stream holds written data (see ByteStream::Storage)
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const ByteStream::Storage storage)
+    : TCPSender([&] {
+        TCPConfig cfg;
+        cfg.send_capacity = capacity;
+        cfg.rt_timeout = retx_timeout;
+        cfg.fixed_isn = fixed_isn;
+        cfg.zero_copy_send = storage == ByteStream::Storage::Chunked;
+        return cfg;
+    }()) {}
+
+//! \param[in] cfg supplies the stream's capacity and storage, the RTO and its bounds, the ISN, the MSS and the
+//!            congestion control
+//! \param[in] timer_wheel where to arm the retransmission timer, if shared with other timers (otherwise the
+//!            TCPSender makes its own, and tick() advances it)
+//! \param[in] timer_token the token the retransmission timer reports to whoever advances `timer_wheel`
+//! \param[in] pacing_timer_token the token the pacing timer reports
 //! remote_window_sz 设置为1，这是因为在三次握手时，发送的syn报文可能需要超时重传。
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
-    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
-    , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity)
-    , _timeout(retx_timeout)
-    , _timecounter(0)
+TCPSender::TCPSender(const TCPConfig &cfg,
+                     shared_ptr<TimingWheel> timer_wheel,
+                     const uint64_t timer_token,
+                     const uint64_t pacing_timer_token)
+    : _isn(cfg.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _rto{cfg.rt_timeout}
+    , _stream(cfg.send_capacity, cfg.zero_copy_send ? ByteStream::Storage::Chunked : ByteStream::Storage::Ring)
+    , _timeout(cfg.rt_timeout)
+    , _owns_timer_wheel(not timer_wheel)
+    , _retx_timer(timer_wheel ? move(timer_wheel) : make_shared<TimingWheel>(), timer_token)
     , _outstanding_queue()
     , _bytes_in_flight(0)
     , _remote_window_sz(1)
     , _sent_syn(false)
     , _sent_fin(false)
-    , _consecutive_retransmissions_count(0) {}
+    , _consecutive_retransmissions_count(0)
+    , _mss(cfg.mss)
+    , _gso(cfg.gso)
+    , _congestion_algorithm(cfg.congestion_control)
+    , _congestion_control(CongestionControl::make(cfg.congestion_control, cfg.mss))
+    , _adaptive_rto(cfg.adaptive_rto)
+    , _rto_min(cfg.rto_min)
+    , _rto_max(cfg.rto_max)
+    , _pacing(cfg.pacing)
+    , _configured_pacing_rate(cfg.pacing_rate)
+    , _pacing_credit(2 * cfg.mss)
+    , _pacing_timer(_retx_timer.shared_wheel(), pacing_timer_token) {}
 
 uint64_t TCPSender::bytes_in_flight() const { return _bytes_in_flight; }
 
@@ -41,8 +78,27 @@ void TCPSender::fill_window() {
     }
     // 对方的window size为0时，需要将其看作1
     size_t window_sz = _remote_window_sz == 0 ? 1 : _remote_window_sz;
+    // 拥塞窗口同样限制在途的数据量，被SACK确认的数据已经离开了网络，不计入其中
+    // 快速恢复期间，每个重复的ack都说明有一个报文离开了网络，可以多发送一个报文
+    if (_congestion_control) {
+        window_sz = min(window_sz, _congestion_control->cwnd() + _recovery_inflation + _sacked_bytes);
+    }
+    // 发送节奏控制：发送额度随时间按速率增加，最多积攒一毫秒的量（至少两个报文）
+    const double rate = pacing_rate();
+    if (rate > 0) {
+        const uint64_t now = _retx_timer.wheel().now();
+        _pacing_credit = min(max<double>(2 * _mss, rate), _pacing_credit + rate * (now - _pacing_refilled_at));
+        _pacing_refilled_at = now;
+    }
     // 填充窗口
     while (window_sz > _bytes_in_flight) {
+        // 额度用完时，等到额度恢复再发送
+        if (rate > 0 && _pacing_credit <= 0) {
+            if (!_sent_syn || _stream.buffer_size() > 0 || _stream.eof()) {
+                _pacing_timer.start(max<uint64_t>(1, ceil(-_pacing_credit / rate)));
+            }
+            break;
+        }
         TCPSegment seg;
         // 如果没有发送过syn报文，则需要设置SYN标记位。第一个发送的一定是SYN报文
         if (!_sent_syn) {
@@ -51,9 +107,16 @@ void TCPSender::fill_window() {
         }
         seg.header().seqno = next_seqno();
         // 将需要发送的数据转入payload
-        size_t len = min(window_sz - _bytes_in_flight - seg.header().syn,
-                         min(TCPConfig::MAX_PAYLOAD_SIZE, _stream.buffer_size()));
-        seg.payload() = move(_stream.read(len));
+        // 启用GSO时，一个报文最多携带64KiB数据（有发送节奏控制时，不超过剩余的发送额度）
+        size_t max_payload = _mss;
+        if (_gso) {
+            max_payload = TCPConfig::MAX_GSO_SIZE;
+            if (rate > 0) {
+                max_payload = max(_mss, min(max_payload, static_cast<size_t>(_pacing_credit)));
+            }
+        }
+        size_t len = min(window_sz - _bytes_in_flight - seg.header().syn, min(max_payload, _stream.buffer_size()));
+        seg.payload() = _stream.read_buffer(len);
         // 如果还有空间且输入结束，则设置fin标志位
         if (!_sent_fin && _stream.eof() && window_sz > seg.length_in_sequence_space() + _bytes_in_flight) {
             seg.header().fin = true;
@@ -68,16 +131,38 @@ void TCPSender::fill_window() {
         // 如果没有正在等待的包，则需要重启计数器
         // if the timer is not running, start it running
         if (_outstanding_queue.empty()) {
-            _timeout = _initial_retransmission_timeout;
-            _timecounter = 0;
+            _timeout = _rto;
+            _retx_timer.start(_timeout);
+        }
+        // 每次只对一个报文计时，测量RTT
+        if ((_adaptive_rto || _pacing) && !_timed) {
+            _timed = _next_seqno + seg.length_in_sequence_space();
+            _timed_sent_at = _retx_timer.wheel().now();
         }
 
-        // 发送报文
+        // 发送报文：发出的是一份拷贝（payload共享同一块内存），报文本身移入 outstanding_queue
+        // 超过MSS的报文作为GSO超级报文整个发出，由adapter切分；outstanding_queue 中保存切分后的报文
+        const size_t seg_len = seg.length_in_sequence_space();
+        if (seg.payload().size() > _mss) {
+            seg.gso_size() = _mss;
+        }
         _segments_out.push(seg);
 
-        _outstanding_queue.push(std::make_pair(_next_seqno, seg));
-        _next_seqno += seg.length_in_sequence_space();
-        _bytes_in_flight += seg.length_in_sequence_space();
+        if (seg.gso_size() > 0) {
+            uint64_t seqno = _next_seqno;
+            for (auto &piece : seg.split()) {
+                const size_t piece_len = piece.length_in_sequence_space();
+                _outstanding_queue.emplace_back(seqno, move(piece));
+                seqno += piece_len;
+            }
+        } else {
+            _outstanding_queue.emplace_back(_next_seqno, move(seg));
+        }
+        _next_seqno += seg_len;
+        _bytes_in_flight += seg_len;
+        if (rate > 0) {
+            _pacing_credit -= seg_len;
+        }
 
         // 如果发送了FIN报文，则跳出循环
         if (_sent_fin) {
@@ -86,22 +171,40 @@ void TCPSender::fill_window() {
     }
 }
 
+void TCPSender::set_mss(const size_t mss) {
+    if (mss == 0 || mss >= _mss) {
+        return;
+    }
+    _mss = mss;
+    _congestion_control = CongestionControl::make(_congestion_algorithm, _mss);
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, before scaling
+//! \param carries_data whether the segment that carried the ACK also occupied sequence space
+//!        (such an ACK is never counted as a duplicate)
+//! \param sack the SACK blocks the segment carried, if the peer agreed to send them
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint16_t window_size,
+                             const bool carries_data,
+                             const vector<TCPHeader::SackBlock> &sack) {
     uint64_t abs_ackno = unwrap(ackno, _isn, _next_seqno);
-    _remote_window_sz = window_size;
+    const size_t previous_window_sz = _remote_window_sz;
+    _remote_window_sz = static_cast<size_t>(window_size) << _remote_window_shift;
     // 如果接收到的非法的ackno，直接返回
     if (abs_ackno > _next_seqno)
         return;
     // 否则，查看 outstanding_queue 中还没有被确认的 segment
     bool reset_flag = false;
+    size_t acked = 0;
     while (!_outstanding_queue.empty()) {
-        auto pair = _outstanding_queue.front();
-        // 如果abs_ackno >= abs_seq(pair.first) + length_in_sequence_space()，表明被正确接收
-        if (abs_ackno >= pair.first + pair.second.length_in_sequence_space()) {
-            _bytes_in_flight -= pair.second.length_in_sequence_space();
-            _outstanding_queue.pop();
+        const auto &[seqno, seg] = _outstanding_queue.front();
+        const size_t seg_len = seg.length_in_sequence_space();
+        // 如果abs_ackno >= abs_seq(seqno) + length_in_sequence_space()，表明被正确接收
+        if (abs_ackno >= seqno + seg_len) {
+            _bytes_in_flight -= seg_len;
+            acked += seg_len;
+            _outstanding_queue.pop_front();
             if (!reset_flag) {
                 reset_flag = true;
             }
@@ -109,30 +212,225 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
             break;
         }
     }
+    update_scoreboard(abs_ackno, sack);
     // 如果有报文被确认了，就可以重置RTO、计数器以及连续重传次数
     if (reset_flag) {
-        _timeout = _initial_retransmission_timeout;
-        _timecounter = 0;
+        // 计时的报文被确认了，得到一个RTT样本
+        if (_timed && abs_ackno >= *_timed) {
+            update_rto(_retx_timer.wheel().now() - _timed_sent_at);
+            _timed.reset();
+        }
+        _timeout = _rto;
         _consecutive_retransmissions_count = 0;
+        _duplicate_acks = 0;
+        // 所有报文都被确认时，停止计时器
+        if (_outstanding_queue.empty()) {
+            _retx_timer.stop();
+        } else {
+            _retx_timer.start(_timeout);
+        }
+        if (_congestion_control) {
+            if (!_fast_recovery) {
+                _congestion_control->on_ack(acked, _bytes_in_flight, _retx_timer.wheel().now());
+            } else if (abs_ackno >= _recover) {
+                // 发生丢包时发出的数据都被确认了，退出快速恢复，拥塞窗口回到 ssthresh
+                _fast_recovery = false;
+                _recovery_inflation = 0;
+            } else if (_sacked.empty()) {
+                // partial ack：下一个未确认的报文也丢失了，立即重传它 (RFC 6582)
+                // 有SACK信息时，由 retransmit_lost_segments 决定重传哪些报文
+                _recovery_inflation = (_recovery_inflation > acked ? _recovery_inflation - acked : 0) + _mss;
+                _segments_out.push(_outstanding_queue.front().second);
+                _high_rxt = max(_high_rxt, abs_ackno + _outstanding_queue.front().second.length_in_sequence_space());
+                _timed.reset();
+            }
+        }
+    } else if (_congestion_control && !carries_data && _remote_window_sz == previous_window_sz &&
+               !_outstanding_queue.empty() && abs_ackno == _outstanding_queue.front().first) {
+        // 重复的ack：接收方收到了乱序的报文，说明最早的未确认报文可能丢失了
+        _duplicate_acks++;
+        if (_fast_recovery) {
+            // 有SACK信息时，在途数据量已经扣除了被SACK确认的数据，不需要再膨胀窗口
+            if (_sacked.empty()) {
+                _recovery_inflation += _mss;
+            }
+        } else if (_duplicate_acks == 3 && abs_ackno > _recover) {
+            // 快速重传，不等待超时
+            _congestion_control->on_loss(_bytes_in_flight, _retx_timer.wheel().now());
+            _fast_recovery = true;
+            _recover = _next_seqno;
+            _recovery_inflation = _sacked.empty() ? 3 * _mss : 0;
+            if (abs_ackno >= _high_rxt) {
+                _segments_out.push(_outstanding_queue.front().second);
+                _high_rxt = abs_ackno + _outstanding_queue.front().second.length_in_sequence_space();
+            }
+            _timed.reset();
+        }
+    }
+    // SACK显示丢失的报文在一个RTT内全部重传，而不是每个RTT重传一个
+    if (retransmit_lost_segments() && _congestion_control && !_fast_recovery && abs_ackno > _recover) {
+        _congestion_control->on_loss(_bytes_in_flight - _sacked_bytes, _retx_timer.wheel().now());
+        _fast_recovery = true;
+        _recover = _next_seqno;
+        _recovery_inflation = 0;
     }
     fill_window();
 }
 
+//! \param abs_ackno the (absolute) ackno of the ACK that carried the blocks
+//! \param sack the blocks, which are ignored unless they lie within the outstanding data
+void TCPSender::update_scoreboard(const uint64_t abs_ackno, const vector<TCPHeader::SackBlock> &sack) {
+    for (const auto &block : sack) {
+        uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        if (left >= right || left < abs_ackno || right > _next_seqno) {
+            continue;
+        }
+        // 与已有的区间合并
+        auto it = _sacked.upper_bound(left);
+        if (it != _sacked.begin() && prev(it)->second >= left) {
+            --it;
+        }
+        while (it != _sacked.end() && it->first <= right) {
+            left = min(left, it->first);
+            right = max(right, it->second);
+            _sacked_bytes -= it->second - it->first;
+            it = _sacked.erase(it);
+        }
+        _sacked.emplace_hint(it, left, right);
+        _sacked_bytes += right - left;
+    }
+
+    // 已经被累计确认的部分不再需要记录
+    while (!_sacked.empty() && _sacked.begin()->first < abs_ackno) {
+        const auto [left, right] = *_sacked.begin();
+        _sacked.erase(_sacked.begin());
+        _sacked_bytes -= right - left;
+        if (right > abs_ackno) {
+            _sacked.emplace(abs_ackno, right);
+            _sacked_bytes += right - abs_ackno;
+        }
+    }
+}
+
+bool TCPSender::retransmit_lost_segments() {
+    // 一个报文之上被SACK确认的数据超过 (DupThresh - 1) * MSS 时，认为它丢失了 (RFC 6675)
+    const size_t lost_threshold = 2 * _mss + 1;
+    if (_sacked_bytes < lost_threshold) {
+        return false;
+    }
+
+    bool retransmitted = false;
+    size_t sacked_below = 0;  // bytes of the ranges that end at or before the current segment's end
+    auto range = _sacked.begin();
+    for (const auto &[seqno, seg] : _outstanding_queue) {
+        const uint64_t end = seqno + seg.length_in_sequence_space();
+        while (range != _sacked.end() && range->second <= end) {
+            sacked_below += range->second - range->first;
+            ++range;
+        }
+        const size_t straddling = range != _sacked.end() && range->first < end ? end - range->first : 0;
+        if (_sacked_bytes - sacked_below - straddling < lost_threshold) {
+            break;
+        }
+        const auto covering = _sacked.upper_bound(seqno);
+        const bool sacked = covering != _sacked.begin() && prev(covering)->second >= end;
+        // 每个丢失的报文只重传一次，再次丢失时由超时重传处理
+        if (sacked || end <= _high_rxt) {
+            continue;
+        }
+        _segments_out.push(seg);
+        _high_rxt = end;
+        retransmitted = true;
+    }
+    if (retransmitted) {
+        _timed.reset();
+    }
+    return retransmitted;
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
-    // 这个函数会被定时调用
-    _timecounter += ms_since_last_tick;
+    // 这个函数会被定时调用；计时器到期时会调用 retransmission_timer_expired
+    if (_owns_timer_wheel) {
+        _retx_timer.wheel().advance(ms_since_last_tick, [this](const uint64_t token) {
+            if (token == _pacing_timer.token()) {
+                pacing_timer_expired();
+            } else {
+                retransmission_timer_expired();
+            }
+        });
+    }
+}
+
+void TCPSender::retransmission_timer_expired() {
     // 当超时了并且有数据需要重传时
-    if (_timecounter >= _timeout && !_outstanding_queue.empty()) {
-        auto pair = _outstanding_queue.front();
-        _segments_out.push(pair.second);
-        if (_remote_window_sz > 0) {
-            _timeout *= 2;
+    if (_outstanding_queue.empty()) {
+        return;
+    }
+    const auto &[seqno, seg] = _outstanding_queue.front();
+    _segments_out.push(seg);
+    // Karn 算法：重传过的报文的ack无法区分是对哪一次发送的确认，不能用来测量RTT
+    _timed.reset();
+    // 窗口为0时的探测报文超时不代表网络拥塞
+    if (_remote_window_sz > 0) {
+        _timeout = _adaptive_rto ? min(2 * _timeout, _rto_max) : 2 * _timeout;
+        // 同一个报文的多次超时只算一次拥塞
+        if (_congestion_control && _consecutive_retransmissions_count == 0) {
+            _congestion_control->on_timeout(_bytes_in_flight, _retx_timer.wheel().now());
         }
-        // 记录连续重传次数并且将计数器重置
-        _consecutive_retransmissions_count++;
-        _timecounter = 0;
     }
+    // 超时后退出快速恢复；在已发出的数据被确认之前，重复的ack不再触发快速重传
+    // 超时说明重传的报文也可能丢失了，之后SACK显示丢失的报文可以再重传一次
+    _fast_recovery = false;
+    _recovery_inflation = 0;
+    _duplicate_acks = 0;
+    _recover = _next_seqno;
+    _high_rxt = seqno + seg.length_in_sequence_space();
+    // 记录连续重传次数并且重启计时器
+    _consecutive_retransmissions_count++;
+    _retx_timer.start(_timeout);
+}
+
+//! \param[in] rtt milliseconds from sending a segment (that was never retransmitted) to its acknowledgment
+void TCPSender::update_rto(const uint64_t rtt) {
+    const double r = rtt;
+    if (!_srtt) {
+        _srtt = r;
+        _rttvar = r / 2;
+    } else {
+        _rttvar = 0.75 * _rttvar + 0.25 * abs(*_srtt - r);
+        _srtt = 0.875 * *_srtt + 0.125 * r;
+    }
+    // RTO = SRTT + max(G, 4 * RTTVAR)，时钟粒度G为1ms
+    const double rto = *_srtt + max(1.0, 4 * _rttvar);
+    if (_adaptive_rto) {
+        _rto = clamp(static_cast<unsigned int>(ceil(rto)), _rto_min, _rto_max);
+    }
+}
+
+double TCPSender::pacing_rate() const {
+    if (!_pacing) {
+        return 0;
+    }
+    if (_configured_pacing_rate > 0) {
+        return _configured_pacing_rate;
+    }
+    // 还没有RTT样本时不控制节奏
+    if (!_srtt || *_srtt <= 0) {
+        return 0;
+    }
+    if (!_congestion_control) {
+        return 1.2 * _remote_window_sz / *_srtt;
+    }
+    const size_t cwnd = _congestion_control->cwnd();
+    const double gain = cwnd < _congestion_control->ssthresh() ? 2.0 : 1.2;
+    return gain * min(cwnd, _remote_window_sz) / *_srtt;
+}
+
+optional<size_t> TCPSender::time_until_retransmission() const {
+    // 没有未确认的报文时，重传计时器不运行
+    return _retx_timer.time_left();
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const {
@@ -142,7 +440,6 @@ unsigned int TCPSender::consecutive_retransmissions() const {
 
 void TCPSender::send_empty_segment() {
     // 发送一个空的segment
-    TCPSegment seg;
-    seg.header().seqno = next_seqno();
-    _segments_out.push(seg);
+    _segments_out.emplace();
+    _segments_out.back().header().seqno = next_seqno();
 }
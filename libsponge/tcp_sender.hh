@@ -2,11 +2,17 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
+#include "timing_wheel.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 #include <queue>
 
 //! \brief The "sender" part of a TCP implementation.
@@ -23,8 +29,8 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! retransmission timer for the connection
-    unsigned int _initial_retransmission_timeout;
+    //! retransmission timeout before backoff: rt_timeout, or derived from the measured RTT
+    unsigned int _rto;
 
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
@@ -32,28 +38,92 @@ class TCPSender {
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
-    // 超时时间上限
-    int _timeout;
-    // 计数器
-    int _timecounter;
+    // 当前的RTO
+    unsigned int _timeout;
+    //! does tick() advance the timer's wheel, or does a TCPConnection or other owner do that?
+    bool _owns_timer_wheel;
+    // 重传计时器，只在有未确认的报文时运行
+    WheelTimer _retx_timer;
     // 追踪发出去的但是还没有收到ack的tcpsegment
-    std::queue<std::pair<uint64_t, TCPSegment>> _outstanding_queue;
+    std::deque<std::pair<uint64_t, TCPSegment>> _outstanding_queue;
     // How many sequence numbers are occupied by segments sent but not yet acknowledged
     size_t _bytes_in_flight;
     // 对方的window_size
     size_t _remote_window_sz;
+    //! how far to shift the window field of ACKs left (the peer's window scale)
+    uint8_t _remote_window_shift{0};
     // 是否发送了含有syn标记位的报文
     bool _sent_syn;
     // 是否发送了含有fin标记位的报文
     bool _sent_fin;
     // 连续重传次数
     size_t _consecutive_retransmissions_count;
+    //! largest payload to put in a segment: TCPConfig::mss, or less if the peer asked for less
+    size_t _mss;
+    //! does fill_window() send super-segments (TCPConfig::gso)?
+    bool _gso;
+    //! the congestion control algorithm, to restart the controller with if the MSS changes
+    TCPConfig::Congestion _congestion_algorithm;
+    //! limits the bytes in flight along with the receiver's window (null: only the receiver's window does)
+    std::unique_ptr<CongestionControl> _congestion_control;
+
+    //! \name Fast retransmit and fast recovery (RFC 5681, RFC 6582), only with a congestion controller
+    //!@{
+    unsigned int _duplicate_acks{0};  //!< duplicate ACKs in a row
+    bool _fast_recovery{false};       //!< retransmitted on duplicate ACKs, and waiting for an ACK of `_recover`
+    uint64_t _recover{0};             //!< highest sequence number sent when the last loss was detected
+    size_t _recovery_inflation{0};    //!< extra window while in fast recovery, one MSS per duplicate ACK
+    //!@}
+
+    //! \name SACK scoreboard (RFC 6675), filled from the SACK blocks of the peer's ACKs
+    //!@{
+    std::map<uint64_t, uint64_t> _sacked{};  //!< SACKed ranges [first, second) of absolute seqnos, not overlapping
+    size_t _sacked_bytes{0};                 //!< total size of `_sacked`
+    uint64_t _high_rxt{0};                   //!< end of the highest segment retransmitted because SACK showed it lost
+    //!@}
+
+    //! Add the SACK blocks of an ACK to the scoreboard, and forget everything below `abs_ackno`
+    void update_scoreboard(const uint64_t abs_ackno, const std::vector<TCPHeader::SackBlock> &sack);
+
+    //! Retransmit the outstanding segments that the scoreboard shows were lost
+    //! \returns whether any segment was retransmitted
+    bool retransmit_lost_segments();
+
+    //! \name Round-trip time estimation (RFC 6298), only with TCPConfig::adaptive_rto or TCPConfig::pacing
+    //!@{
+    bool _adaptive_rto;                //!< whether RTT samples update `_rto`
+    unsigned int _rto_min;             //!< lower bound of `_rto`
+    unsigned int _rto_max;             //!< upper bound of `_rto` and of its backoff
+    std::optional<double> _srtt{};     //!< smoothed RTT, once there has been a sample
+    double _rttvar{0};                 //!< RTT variation
+    std::optional<uint64_t> _timed{};  //!< absolute seqno that ends the segment being timed, if any
+    uint64_t _timed_sent_at{0};        //!< when the timed segment was sent
+    //!@}
+
+    //! Take an RTT sample of `rtt` ms and recompute `_rto`
+    void update_rto(const uint64_t rtt);
+
+    //! \name Pacing, only with TCPConfig::pacing
+    //!@{
+    bool _pacing;                     //!< whether fill_window() spreads segments out in time
+    double _configured_pacing_rate;   //!< bytes per ms, or 0 to estimate the rate
+    double _pacing_credit;            //!< bytes that may be sent now; negative once a segment overdraws it
+    uint64_t _pacing_refilled_at{0};  //!< when `_pacing_credit` was last topped up
+    WheelTimer _pacing_timer;         //!< runs while fill_window() waits for credit
+    //!@}
 
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const ByteStream::Storage storage = ByteStream::Storage::Ring);
+
+    //! Initialize a TCPSender from the sending half of a TCPConfig
+    explicit TCPSender(const TCPConfig &cfg,
+                       std::shared_ptr<TimingWheel> timer_wheel = nullptr,
+                       const uint64_t timer_token = 0,
+                       const uint64_t pacing_timer_token = 1);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -65,16 +135,41 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \details With a congestion controller, the third duplicate ACK retransmits the oldest outstanding
+    //! segment without waiting for the retransmission timer, and starts fast recovery.
+    //! Once SACK blocks show that segments were lost (more than two segments' worth of data SACKed above
+    //! them), each of those segments is retransmitted once, right away.
+    void ack_received(const WrappingInt32 ackno,
+                      const uint16_t window_size,
+                      const bool carries_data = false,
+                      const std::vector<TCPHeader::SackBlock> &sack = {});
+
+    //! \brief From now on, shift the window of every ACK left by `shift` bits (RFC 7323)
+    void set_remote_window_scale(const uint8_t shift) { _remote_window_shift = shift; }
+
+    //! \brief Send no more than `mss` bytes of payload per segment, if that is less than TCPConfig::mss
+    //! (the peer's MSS option)
+    //! \note The congestion controller counts in MSS, so it starts over; call this before sending data
+    void set_mss(const size_t mss);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
 
     //! \brief create and send segments to fill as much of the window as possible
+    //! \details With pacing, only as many as the pacing credit allows; the pacing timer calls it again
+    //! once there is more. With GSO, each segment in segments_out() may be a super-segment, while the
+    //! outstanding segments (and so any retransmissions) are its MSS-sized pieces.
     void fill_window();
 
     //! \brief Notifies the TCPSender of the passage of time
+    //! \note Only a TCPSender with its own timer wheel keeps time this way; see retransmission_timer_expired().
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief The retransmission timer's token came up on the timer wheel this TCPSender was built with
+    void retransmission_timer_expired();
+
+    //! \brief The pacing timer's token came up on the timer wheel this TCPSender was built with
+    void pacing_timer_expired() { fill_window(); }
     //!@}
 
     //! \name Accessors
@@ -88,6 +183,30 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Milliseconds of ticks left before the retransmission timer expires, if it is running
+    std::optional<size_t> time_until_retransmission() const;
+
+    //! \brief Milliseconds of ticks left before pacing lets the next segment out, if one is waiting
+    std::optional<size_t> time_until_paced_send() const { return _pacing_timer.time_left(); }
+
+    //! \brief The rate fill_window() paces segments at, in bytes per millisecond (0: not pacing)
+    //! \details TCPConfig::pacing_rate if set; otherwise the window over the smoothed RTT, times 2 in slow start
+    //! and 1.2 after it (as Linux does), once an RTT has been measured
+    double pacing_rate() const;
+
+    //! \brief Smoothed round-trip time in milliseconds, once an RTT has been measured
+    //! \note RTTs are only measured with TCPConfig::adaptive_rto or TCPConfig::pacing
+    std::optional<double> srtt() const { return _srtt; }
+
+    //! \brief The current retransmission timeout in milliseconds, including any backoff
+    unsigned int rto() const { return _timeout; }
+
+    //! \brief Largest payload the TCPSender puts in a segment
+    size_t mss() const { return _mss; }
+
+    //! \brief The congestion controller, if TCPConfig::congestion_control chose one
+    const CongestionControl *congestion_control() const { return _congestion_control.get(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
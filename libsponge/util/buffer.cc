@@ -7,11 +7,28 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
         _storage.reset();
     }
 }
 
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _ending_offset += n;
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
+        _storage.reset();
+    }
+}
+
+//! \note Storage no bigger than a std::string holds its bytes inline, so it is never worth copying out of.
+void Buffer::compact() {
+    if (storage_size() > sizeof(string) and 2 * size() < storage_size()) {
+        *this = Buffer{copy()};
+    }
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
@@ -97,8 +114,12 @@ size_t BufferViewList::size() const {
 vector<iovec> BufferViewList::as_iovecs() const {
     vector<iovec> ret;
     ret.reserve(_views.size());
+    append_iovecs(ret);
+    return ret;
+}
+
+void BufferViewList::append_iovecs(vector<iovec> &iovecs) const {
     for (const auto &x : _views) {
-        ret.push_back({const_cast<char *>(x.data()), x.size()});
+        iovecs.push_back({const_cast<char *>(x.data()), x.size()});
     }
-    return ret;
 }
@@ -16,6 +16,7 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _ending_offset{};
 
   public:
     Buffer() = default;
@@ -29,7 +30,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _ending_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +48,18 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer that share the same storage are unaffected.
+    void remove_suffix(const size_t n);
+
+    //! \brief Heap bytes this Buffer keeps alive: all of its storage, not just the bytes it shows
+    size_t storage_size() const { return _storage ? _storage->capacity() : 0; }
+
+    //! \brief Copy the bytes into storage of their own if they are less than half of the storage they share
+    //! \details Keeps a small slice (e.g. one segment's payload) from pinning a large buffer (e.g. a whole
+    //! received datagram) for as long as it is held.
+    void compact();
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -113,6 +126,9 @@ class BufferViewList {
 
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+
+    //! \brief Construct from a sequence of std::string_views
+    BufferViewList(std::deque<std::string_view> views) : _views(std::move(views)) {}
     //!@}
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
@@ -125,6 +141,9 @@ class BufferViewList {
     //! \note used for system calls that write discontiguous buffers,
     //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
     std::vector<iovec> as_iovecs() const;
+
+    //! \brief Append an `iovec` for each view to `iovecs`, as as_iovecs() does, into storage the caller reuses
+    void append_iovecs(std::vector<iovec> &iovecs) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
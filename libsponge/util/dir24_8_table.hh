@@ -0,0 +1,192 @@
+#ifndef SPONGE_LIBSPONGE_DIR24_8_TABLE_HH
+#define SPONGE_LIBSPONGE_DIR24_8_TABLE_HH
+
+#include "prefix_trie.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A DIR-24-8 longest-prefix-match table mapping IPv4 prefixes to values.
+//!
+//! A first-level array with one entry for every /24 answers any lookup whose longest match
+//! is no longer than 24 bits in a single memory access. A /24 covered by longer prefixes
+//! instead points to a 256-entry second-level block indexed by the address's last byte.
+//!
+//! Each entry stores the index of the matching value and the length of the prefix it came
+//! from, so that adding or removing a prefix only rewrites the entries that prefix covers.
+//! A PrefixTrie of the installed prefixes finds the covering route to fall back to when a
+//! prefix is removed. The first-level array alone takes 64 MiB.
+template <typename T>
+class Dir24_8Table {
+  private:
+    //! An installed prefix: where its value lives, and its length
+    struct Route {
+        uint32_t slot;
+        uint8_t length;
+    };
+
+    // entry layout: [31] points to a second-level block, [29:24] prefix length, [23:0] value slot + 1 (0 = no route)
+    static constexpr uint32_t EXTENDED = uint32_t(1) << 31;
+    static constexpr uint32_t SLOT_MASK = (uint32_t(1) << 24) - 1;
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    std::vector<uint32_t> _tbl24 = std::vector<uint32_t>(size_t(1) << 24);  //!< Indexed by the top 24 bits
+    std::vector<uint32_t> _tbl8{};                                          //!< Second-level blocks, back to back
+    std::vector<uint32_t> _free_blocks{};                                   //!< Unused blocks in `_tbl8`
+    std::vector<std::optional<T>> _values{};                                //!< Indexed by slot
+    std::vector<uint32_t> _free_slots{};                                    //!< Unused slots in `_values`
+    PrefixTrie<Route> _routes{};                                            //!< The installed prefixes
+
+    static uint32_t mask(const uint8_t length) { return length == 0 ? 0 : ~uint32_t(0) << (32 - length); }
+
+    static uint32_t make_entry(const Route &route) { return uint32_t(route.length) << 24 | (route.slot + 1); }
+    static uint8_t entry_length(const uint32_t entry) { return (entry >> 24) & 0x3f; }
+
+    //! Whether `entry` came from a prefix whose length lies in [min_length, max_length]
+    static bool in_range(const uint32_t entry, const uint8_t min_length, const uint8_t max_length) {
+        const uint8_t length = entry_length(entry);
+        return length >= min_length and length <= max_length;
+    }
+
+    //! Rewrite the entries in `block` whose prefix length lies in [min_length, max_length]
+    void assign_block(const uint32_t block,
+                      const size_t first,
+                      const size_t count,
+                      const uint8_t min_length,
+                      const uint8_t max_length,
+                      const uint32_t entry) {
+        uint32_t *const base = &_tbl8[block * BLOCK_SIZE];
+        for (size_t i = first; i < first + count; i++) {
+            if (in_range(base[i], min_length, max_length)) {
+                base[i] = entry;
+            }
+        }
+    }
+
+    //! Fold the block behind first-level entry `index` back into it if no entry in the block needs it any more
+    void try_fold(const size_t index) {
+        const uint32_t block = _tbl24[index] & ~EXTENDED;
+        const uint32_t *const base = &_tbl8[block * BLOCK_SIZE];
+        if (entry_length(base[0]) > 24) {
+            return;
+        }
+        for (size_t i = 1; i < BLOCK_SIZE; i++) {
+            if (base[i] != base[0]) {
+                return;
+            }
+        }
+        _tbl24[index] = base[0];
+        _free_blocks.push_back(block);
+    }
+
+    //! Point every entry covered by `prefix`/`length` whose prefix length lies in [min_length, length] at `entry`
+    void assign(const uint32_t prefix, const uint8_t length, const uint8_t min_length, const uint32_t entry) {
+        if (length <= 24) {
+            const size_t first = prefix >> 8;
+            for (size_t i = first; i < first + (size_t(1) << (24 - length)); i++) {
+                if (_tbl24[i] & EXTENDED) {
+                    assign_block(_tbl24[i] & ~EXTENDED, 0, BLOCK_SIZE, min_length, length, entry);
+                    try_fold(i);
+                } else if (in_range(_tbl24[i], min_length, length)) {
+                    _tbl24[i] = entry;
+                }
+            }
+            return;
+        }
+
+        const size_t index = prefix >> 8;
+        if (not(_tbl24[index] & EXTENDED)) {
+            // split the /24 into a block that starts out with the /24's current entry everywhere
+            uint32_t block;
+            if (_free_blocks.empty()) {
+                block = _tbl8.size() / BLOCK_SIZE;
+                if (block >= EXTENDED) {
+                    throw std::length_error("Dir24_8Table: too many second-level blocks");
+                }
+                _tbl8.resize(_tbl8.size() + BLOCK_SIZE);
+            } else {
+                block = _free_blocks.back();
+                _free_blocks.pop_back();
+            }
+            std::fill_n(&_tbl8[block * BLOCK_SIZE], BLOCK_SIZE, _tbl24[index]);
+            _tbl24[index] = EXTENDED | block;
+        }
+        assign_block(_tbl24[index] & ~EXTENDED, prefix & 0xff, size_t(1) << (32 - length), min_length, length, entry);
+        try_fold(index);
+    }
+
+  public:
+    //! \brief Store `value` for `prefix`/`length`, replacing any value already stored for it
+    //! \note Bits of `prefix` past `length` are ignored.
+    void insert(uint32_t prefix, const uint8_t length, T value) {
+        prefix &= mask(length);
+        if (const Route *existing = _routes.find(prefix, length)) {
+            _values[existing->slot] = std::move(value);
+            return;
+        }
+
+        Route route{0, length};
+        if (_free_slots.empty()) {
+            if (_values.size() >= SLOT_MASK) {
+                throw std::length_error("Dir24_8Table: too many routes");
+            }
+            route.slot = _values.size();
+            _values.emplace_back(std::move(value));
+        } else {
+            route.slot = _free_slots.back();
+            _free_slots.pop_back();
+            _values[route.slot] = std::move(value);
+        }
+        _routes.insert(prefix, length, route);
+
+        // the new route takes over every covered entry that held a shorter (or no) prefix
+        assign(prefix, length, 0, make_entry(route));
+    }
+
+    //! \brief Remove the value stored for exactly `prefix`/`length`
+    //! \returns `true` if there was one
+    bool erase(uint32_t prefix, const uint8_t length) {
+        prefix &= mask(length);
+        const Route *existing = _routes.find(prefix, length);
+        if (not existing) {
+            return false;
+        }
+        const uint32_t slot = existing->slot;
+        _routes.erase(prefix, length);
+        _values[slot].reset();
+        _free_slots.push_back(slot);
+
+        // entries that held this prefix fall back to the longest shorter prefix covering it, if any
+        const Route *covering = length == 0 ? nullptr : _routes.lookup(prefix, length - 1);
+        assign(prefix, length, length, covering ? make_entry(*covering) : 0);
+        return true;
+    }
+
+    //! \returns the value stored for the longest prefix that matches `address`, or nullptr
+    const T *lookup(const uint32_t address) const {
+        uint32_t entry = _tbl24[address >> 8];
+        if (entry & EXTENDED) {
+            entry = _tbl8[(entry & ~EXTENDED) * BLOCK_SIZE + (address & 0xff)];
+        }
+        const uint32_t slot = entry & SLOT_MASK;
+        return slot == 0 ? nullptr : &_values[slot - 1].value();
+    }
+
+    //! Number of prefixes stored
+    size_t size() const { return _routes.size(); }
+
+    //! Bytes used by the lookup tables and the prefixes' bookkeeping
+    //! (not counting any memory owned by the values themselves)
+    size_t memory_usage() const {
+        return sizeof(*this) + (_tbl24.capacity() + _tbl8.capacity() + _free_blocks.capacity()) * sizeof(uint32_t) +
+               _values.capacity() * sizeof(std::optional<T>) + _free_slots.capacity() * sizeof(uint32_t) +
+               _routes.memory_usage();
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_DIR24_8_TABLE_HH
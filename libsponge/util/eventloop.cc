@@ -2,7 +2,9 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <limits>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -14,6 +16,16 @@ unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+//! The epoll events corresponding to a Direction
+static uint32_t epoll_interest(const Direction direction) { return direction == Direction::In ? EPOLLIN : EPOLLOUT; }
+
+//! \param[in] backend selects the system call used to wait for events
+EventLoop::EventLoop(const Backend backend) {
+    if (backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+}
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
@@ -26,6 +38,89 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const InterestT &interest,
                          const CallbackT &cancel) {
     _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+
+    if (_epoll) {
+        auto &entry = _epoll_entries[fd.fd_num()];
+        // a new fd (or a new one reusing the number of a closed fd whose rules haven't been canceled yet)
+        // is only added to the epoll instance to see whether epoll can watch it; wait_next_event adds it
+        // again once a rule is interested
+        if (entry.rules.empty() or entry.rules.front()->fd.closed()) {
+            epoll_event event{};
+            event.data.fd = fd.fd_num();
+            const bool was_always_ready = entry.always_ready;
+            entry.events = 0;
+            entry.always_ready = false;
+            if (::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd.fd_num(), &event) < 0) {
+                if (errno == EPERM) {
+                    // regular files can't be added to an epoll instance; like poll, treat them as always ready
+                    entry.always_ready = true;
+                } else if (errno != EEXIST) {
+                    throw unix_error("epoll_ctl");
+                }
+            }
+            if (not entry.always_ready) {
+                SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd.fd_num(), nullptr));
+            }
+            if (entry.always_ready and not was_always_ready) {
+                _always_ready_fds.push_back(fd.fd_num());
+            } else if (was_always_ready and not entry.always_ready) {
+                _always_ready_fds.erase(find(_always_ready_fds.begin(), _always_ready_fds.end(), fd.fd_num()));
+            }
+        }
+        entry.rules.push_back(prev(_rules.end()));
+    }
+}
+
+//! \param[in] rule is the rule to remove
+//! \returns the rule after it in EventLoop::_rules
+EventLoop::RuleIterator EventLoop::erase_rule(const RuleIterator rule) {
+    if (_epoll) {
+        const int fd_num = rule->fd.fd_num();
+        const auto entry = _epoll_entries.find(fd_num);
+        if (entry != _epoll_entries.end()) {
+            auto &rules = entry->second.rules;
+            rules.erase(find(rules.begin(), rules.end(), rule));
+            if (rules.empty()) {
+                if (entry->second.always_ready) {
+                    _always_ready_fds.erase(find(_always_ready_fds.begin(), _always_ready_fds.end(), fd_num));
+                } else {
+                    // fails harmlessly if the fd was already closed (which also removes it from the epoll instance)
+                    ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr);
+                }
+                _epoll_entries.erase(entry);
+            } else {
+                _dirty_fds.push_back(fd_num);
+            }
+        }
+    }
+    return _rules.erase(rule);
+}
+
+//! \param[in] fd_num is the fd to re-register
+//! \param[in] entry holds the rules for `fd_num`
+void EventLoop::rearm(const int fd_num, EpollEntry &entry) {
+    uint32_t events = 0;
+    for (const auto &rule : entry.rules) {
+        if (rule->interested) {
+            events |= epoll_interest(rule->direction);
+        }
+    }
+    if (events == entry.events) {
+        return;
+    }
+    if (entry.always_ready) {
+        entry.events = events;
+        return;
+    }
+
+    // epoll reports hangups and errors even for an fd registered for no events, so (as with poll) an fd that
+    // no rule is interested in stays out of the epoll instance
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd_num;
+    const int op = events == 0 ? EPOLL_CTL_DEL : (entry.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+    SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), op, fd_num, &event));
+    entry.events = events;
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -37,18 +132,20 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! writability (if Rule::direction == Direction::Out) unless Rule::fd has reached EOF, in which case
 //! the Rule is canceled (i.e., deleted from EventLoop::_rules).
 //!
-//! Next, this function calls [poll(2)](\ref man2::poll) with timeout value `timeout_ms`.
+//! Next, this function calls [poll(2)](\ref man2::poll) with timeout value `timeout_ms`, shortened if
+//! necessary so that it returns by the time the next timer added with EventLoop::add_timer is due.
 //!
 //! Then, for each ready file descriptor, this function calls Rule::callback. If fd reaches EOF or
 //! if the Rule was registered using EventLoop::add_cancelable_rule and Rule::callback returns true,
-//! this Rule is canceled.
+//! this Rule is canceled. After that, it calls the callback of each timer whose deadline has passed.
 //!
 //! If an error occurs during polling, this function throws a std::runtime_error.
 //!
-//! If a [signal(7)](\ref man7::signal) was caught during polling or if EventLoop::_rules becomes empty,
-//! this function returns Result::Exit.
+//! If a [signal(7)](\ref man7::signal) was caught during polling or if EventLoop::_rules becomes empty
+//! while no timers are pending, this function returns Result::Exit.
 //!
-//! If a timeout occurred while polling (i.e., no fd became ready), this function returns Result::Timeout.
+//! If a timeout occurred while polling (i.e., no fd became ready and no timer fired), this function returns
+//! Result::Timeout.
 //!
 //! Otherwise, this function returns Result::Success.
 //!
@@ -59,6 +156,92 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    const int timeout = timeout_until_next_timer(timeout_ms);
+    const Result result = _epoll ? wait_next_event_epoll(timeout) : wait_next_event_poll(timeout);
+    if (result == Result::Exit) {
+        return result;
+    }
+    return run_expired_timers() ? Result::Success : result;
+}
+
+//! \param[in] delay_ms is how long from now the callback should first be called
+//! \param[in] callback is called when the timer expires
+//! \param[in] interval_ms is how often the callback should be called after that, or 0 to call it only once
+//! \returns an ID that can be passed to EventLoop::cancel_timer
+EventLoop::TimerID EventLoop::add_timer(const uint64_t delay_ms,
+                                        const CallbackT &callback,
+                                        const uint64_t interval_ms) {
+    // entries for canceled timers are only removed once they reach the front; don't let them pile up
+    if (_timer_queue.size() > 2 * _timers.size() + 64) {
+        decltype(_timer_queue) live_entries{};
+        for (const auto &[id, timer] : _timers) {
+            live_entries.emplace(timer.deadline, id);
+        }
+        _timer_queue = move(live_entries);
+    }
+
+    const TimerID id = _next_timer_id++;
+    const uint64_t deadline = timestamp_ms() + delay_ms;
+    _timers.emplace(id, Timer{deadline, interval_ms, callback});
+    _timer_queue.emplace(deadline, id);
+    return id;
+}
+
+//! \param[in] id is the timer to cancel, as returned by EventLoop::add_timer
+bool EventLoop::cancel_timer(const TimerID id) { return _timers.erase(id) > 0; }
+
+//! \param[in] timeout_ms is the caller's timeout (negative means wait indefinitely)
+//! \returns the smaller of `timeout_ms` and the time until the next timer is due
+int EventLoop::timeout_until_next_timer(const int timeout_ms) {
+    // drop entries of canceled or rescheduled timers from the front of the queue
+    while (not _timer_queue.empty()) {
+        const auto timer = _timers.find(_timer_queue.top().second);
+        if (timer != _timers.end() and timer->second.deadline == _timer_queue.top().first) {
+            break;
+        }
+        _timer_queue.pop();
+    }
+    if (_timer_queue.empty()) {
+        return timeout_ms;
+    }
+
+    const uint64_t now = timestamp_ms();
+    const uint64_t next_deadline = _timer_queue.top().first;
+    const uint64_t until_next = next_deadline > now ? next_deadline - now : 0;
+    if (timeout_ms < 0 or until_next < uint64_t(timeout_ms)) {
+        return static_cast<int>(min(until_next, uint64_t(numeric_limits<int>::max())));
+    }
+    return timeout_ms;
+}
+
+bool EventLoop::run_expired_timers() {
+    bool fired = false;
+    const uint64_t now = timestamp_ms();
+    while (not _timer_queue.empty() and _timer_queue.top().first <= now) {
+        const auto [deadline, id] = _timer_queue.top();
+        _timer_queue.pop();
+        const auto timer = _timers.find(id);
+        if (timer == _timers.end() or timer->second.deadline != deadline) {
+            continue;  // canceled, or a stale entry
+        }
+
+        // copy the callback, since it may cancel its own timer
+        const CallbackT callback = timer->second.callback;
+        if (timer->second.interval > 0) {
+            // reschedule, skipping any periods that were missed entirely
+            const uint64_t interval = timer->second.interval;
+            timer->second.deadline = deadline + interval > now ? deadline + interval : now + interval;
+            _timer_queue.emplace(timer->second.deadline, id);
+        } else {
+            _timers.erase(timer);
+        }
+        callback();
+        fired = true;
+    }
+    return fired;
+}
+
+EventLoop::Result EventLoop::wait_next_event_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -83,13 +266,15 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             pollfds.push_back({this_rule.fd.fd_num(), static_cast<short>(this_rule.direction), 0});
             something_to_poll = true;
         } else {
-            pollfds.push_back({this_rule.fd.fd_num(), 0, 0});  // placeholder --- we still want errors
+            // placeholder --- a negative fd is ignored, as poll would otherwise report a hangup (or error) on it
+            // every time, without any rule to handle it
+            pollfds.push_back({-1, 0, 0});
         }
         ++it;
     }
 
-    // quit if there is nothing left to poll
-    if (not something_to_poll) {
+    // quit if there is nothing left to poll or wait for
+    if (not something_to_poll and _timers.empty()) {
         return Result::Exit;
     }
 
@@ -143,3 +328,117 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! Behaves like the poll backend, but instead of building a pollfd for every rule, only re-registers the fds
+//! whose rules' interest changed, and only visits the rules of the fds that epoll_wait reports as ready.
+EventLoop::Result EventLoop::wait_next_event_epoll(const int timeout_ms) {
+    bool something_to_poll = false;
+
+    // cancel finished rules, and note the fds whose rules changed their interest
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
+        auto &this_rule = *it;
+        if ((this_rule.direction == Direction::In && this_rule.fd.eof()) or this_rule.fd.closed()) {
+            this_rule.cancel();
+            it = erase_rule(it);
+            continue;
+        }
+
+        const bool interested = this_rule.interest();
+        if (interested != this_rule.interested) {
+            this_rule.interested = interested;
+            _dirty_fds.push_back(this_rule.fd.fd_num());
+        }
+        something_to_poll |= interested;
+        ++it;
+    }
+
+    // quit if there is nothing left to poll or wait for
+    if (not something_to_poll and _timers.empty()) {
+        return Result::Exit;
+    }
+
+    for (const int fd_num : _dirty_fds) {
+        const auto entry = _epoll_entries.find(fd_num);
+        if (entry != _epoll_entries.end()) {
+            rearm(fd_num, entry->second);
+        }
+    }
+    _dirty_fds.clear();
+
+    // an interested fd that is always ready means there's no waiting
+    vector<pair<int, uint32_t>> always_ready{};
+    for (const int fd_num : _always_ready_fds) {
+        const uint32_t events = _epoll_entries.at(fd_num).events;
+        if (events != 0) {
+            always_ready.emplace_back(fd_num, events);
+        }
+    }
+
+    // wait until one of the registered fds is ready (level triggered, like poll)
+    _epoll_events.resize(max(min(_epoll_entries.size(), size_t(1024)), size_t(1)));
+    int ready = 0;
+    try {
+        ready = SystemCall("epoll_wait",
+                           ::epoll_wait(_epoll->fd_num(),
+                                        _epoll_events.data(),
+                                        _epoll_events.size(),
+                                        always_ready.empty() ? timeout_ms : 0));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready == 0 and always_ready.empty()) {
+        return Result::Timeout;
+    }
+
+    // go through the ready fds
+    for (int idx = 0; idx < ready; idx++) {
+        const auto &this_event = _epoll_events[idx];
+        if (this_event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+        dispatch(this_event.data.fd, this_event.events);
+    }
+    for (const auto &[fd_num, events] : always_ready) {
+        dispatch(fd_num, events);
+    }
+
+    return Result::Success;
+}
+
+//! \param[in] fd_num is the fd that is ready
+//! \param[in] revents is the set of events that occurred on it
+void EventLoop::dispatch(const int fd_num, const uint32_t revents) {
+    const auto entry = _epoll_entries.find(fd_num);
+    if (entry == _epoll_entries.end()) {
+        return;
+    }
+
+    // callbacks may add rules and cancellations remove them, so work from a copy
+    const vector<RuleIterator> rules = entry->second.rules;
+    for (const auto &rule : rules) {
+        auto &this_rule = *rule;
+        const uint32_t wanted = this_rule.interested ? epoll_interest(this_rule.direction) : 0;
+        const auto poll_ready = static_cast<bool>(revents & wanted);
+        const auto poll_hup = static_cast<bool>(revents & EPOLLHUP);
+        if (poll_hup && wanted && !poll_ready) {
+            // same as for poll: the only condition was a hangup, so this FD is defunct
+            this_rule.cancel();
+            erase_rule(rule);
+            continue;
+        }
+
+        if (poll_ready) {
+            const auto count_before = this_rule.service_count();
+            this_rule.callback();
+
+            // only check for busy wait if we're not canceling or exiting
+            if (count_before == this_rule.service_count() and this_rule.interest()) {
+                throw runtime_error(
+                    "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+            }
+        }
+    }
+}
@@ -3,10 +3,16 @@
 
 #include "file_descriptor.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <queue>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +23,12 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! The system call EventLoop::wait_next_event uses to wait for activity.
+    enum class Backend {
+        Poll,  //!< [poll(2)](\ref man2::poll) on every Rule::fd, rebuilt on each call
+        Epoll  //!< [epoll_wait(2)](\ref man2::epoll_wait) on fds that stay registered across calls
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -25,27 +37,83 @@ class EventLoop {
     //! \details Created by calling EventLoop::add_rule() or EventLoop::add_cancelable_rule().
     class Rule {
       public:
-        FileDescriptor fd;    //!< FileDescriptor to monitor for activity.
-        Direction direction;  //!< Direction::In for reading from fd, Direction::Out for writing to fd.
-        CallbackT callback;   //!< A callback that reads or writes fd.
-        InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
-        CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        FileDescriptor fd;        //!< FileDescriptor to monitor for activity.
+        Direction direction;      //!< Direction::In for reading from fd, Direction::Out for writing to fd.
+        CallbackT callback;       //!< A callback that reads or writes fd.
+        InterestT interest;       //!< A callback that returns `true` whenever fd should be polled.
+        CallbackT cancel;         //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool interested = false;  //!< What Rule::interest returned the last time it was called (Epoll only)
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
     };
 
+    using RuleIterator = std::list<Rule>::iterator;
+
+  public:
+    using TimerID = uint64_t;  //!< Identifies a timer added with EventLoop::add_timer
+
+  private:
+    //! \brief A callback that an EventLoop should call at a given time.
+    //! \details Created by calling EventLoop::add_timer().
+    struct Timer {
+        uint64_t deadline;   //!< When the callback is next due, in milliseconds (see timestamp_ms())
+        uint64_t interval;   //!< Period in milliseconds, or 0 for a one-shot timer
+        CallbackT callback;  //!< Called once the deadline has passed
+    };
+
+    std::unordered_map<TimerID, Timer> _timers{};  //!< All timers that have been added and not canceled or expired.
+    //! Deadlines of the timers, soonest first; entries of canceled or rescheduled timers are skipped when popped
+    std::priority_queue<std::pair<uint64_t, TimerID>,
+                        std::vector<std::pair<uint64_t, TimerID>>,
+                        std::greater<std::pair<uint64_t, TimerID>>>
+        _timer_queue{};
+    TimerID _next_timer_id{1};  //!< The ID the next timer will be given
+
+    //! The timeout to wait for, given the caller's timeout and the next timer deadline
+    int timeout_until_next_timer(const int timeout_ms);
+
+    //! Call the callbacks of all timers whose deadlines have passed
+    //! \returns `true` if any timer fired
+    bool run_expired_timers();
+
+    //! The rules watching one fd, and the events that fd is currently registered for (Epoll only; with no
+    //! events, the fd is left out of the epoll instance).
+    struct EpollEntry {
+        std::vector<RuleIterator> rules{};
+        uint32_t events = 0;
+        bool always_ready = false;  //!< epoll can't watch this fd (e.g. a regular file), which poll treats as ready
+    };
+
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    std::optional<FileDescriptor> _epoll{};                //!< The epoll instance, if using Backend::Epoll
+    std::unordered_map<int, EpollEntry> _epoll_entries{};  //!< Registered fds, by fd number
+    std::vector<int> _dirty_fds{};                         //!< Fds whose rules' interest may have changed
+    std::vector<int> _always_ready_fds{};                  //!< Fds with EpollEntry::always_ready set
+    std::vector<epoll_event> _epoll_events{};              //!< Storage for the results of epoll_wait
+
+    //! Cancel a rule, returning the next one
+    RuleIterator erase_rule(const RuleIterator rule);
+
+    //! Change the events `fd_num` is registered for to match its rules' current interest
+    void rearm(const int fd_num, EpollEntry &entry);
+
+    //! Run the callbacks of the rules on `fd_num` that are ready according to `revents`
+    void dispatch(const int fd_num, const uint32_t revents);
+
   public:
     //! Returned by each call to EventLoop::wait_next_event.
     enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
+        Success,  //!< At least one Rule or timer was triggered.
+        Timeout,  //!< No rules or timers were triggered before timeout.
         Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
     };
 
+    //! Construct an EventLoop that waits using the given Backend
+    explicit EventLoop(const Backend backend = Backend::Epoll);
+
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
     void add_rule(const FileDescriptor &fd,
                   const Direction direction,
@@ -53,16 +121,30 @@ class EventLoop {
                   const InterestT &interest = [] { return true; },
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! Add a timer whose callback will be called `delay_ms` from now, and then every `interval_ms` if nonzero.
+    TimerID add_timer(const uint64_t delay_ms, const CallbackT &callback, const uint64_t interval_ms = 0);
+
+    //! Cancel a timer so that its callback is not called (again).
+    //! \returns `true` if the timer was still pending
+    bool cancel_timer(const TimerID id);
+
+    //! Calls [poll(2)](\ref man2::poll) or [epoll_wait(2)](\ref man2::epoll_wait) and then executes
+    //! callback for each ready fd and each expired timer.
     Result wait_next_event(const int timeout_ms);
+
+  private:
+    Result wait_next_event_poll(const int timeout_ms);
+    Result wait_next_event_epoll(const int timeout_ms);
 };
 
 using Direction = EventLoop::Direction;
 
 //! \class EventLoop
 //!
-//! An EventLoop holds a std::list of Rule objects. Each time EventLoop::wait_next_event is
-//! executed, the EventLoop uses the Rule objects to construct a call to [poll(2)](\ref man2::poll).
+//! An EventLoop holds a std::list of Rule objects. With Backend::Poll, each time EventLoop::wait_next_event
+//! is executed, the EventLoop uses the Rule objects to construct a call to [poll(2)](\ref man2::poll).
+//! With Backend::Epoll (the default), each Rule::fd stays registered with an epoll instance, its registration
+//! is only changed when a Rule::interest result changes, and only the rules on ready fds are visited afterwards.
 //!
 //! When a Rule is installed using EventLoop::add_rule, it will be polled for the specified Rule::direction
 //! whenver the Rule::interest callback returns `true`, until Rule::fd is no longer readable
@@ -72,5 +154,8 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! A timer installed using EventLoop::add_timer shortens the wait so that its callback runs as soon as
+//! its deadline passes. Pending timers keep EventLoop::wait_next_event from returning Result::Exit.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
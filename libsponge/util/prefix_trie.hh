@@ -0,0 +1,152 @@
+#ifndef SPONGE_LIBSPONGE_PREFIX_TRIE_HH
+#define SPONGE_LIBSPONGE_PREFIX_TRIE_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! \brief A path-compressed binary (Patricia) trie mapping IPv4 prefixes to values,
+//! supporting longest-prefix-match lookups.
+//!
+//! Each node stores a whole prefix, so chains of single-child nodes are never materialized.
+//! Every step of a lookup moves to a strictly longer prefix, so it visits at most 33 nodes
+//! regardless of how many prefixes are stored.
+template <typename T>
+class PrefixTrie {
+  private:
+    struct Node {
+        uint32_t prefix;                               //!< Prefix bits (all bits past `length` are zero)
+        uint8_t length;                                //!< Number of significant (high-order) bits
+        std::optional<T> value{};                      //!< Value stored for exactly this prefix, if any
+        std::array<std::unique_ptr<Node>, 2> child{};  //!< Subtries whose next bit is 0 or 1
+
+        Node(const uint32_t prefix_, const uint8_t length_) : prefix(prefix_), length(length_) {}
+    };
+
+    std::unique_ptr<Node> _root = std::make_unique<Node>(0, 0);
+    size_t _size = 0;
+    size_t _nodes = 1;
+
+    //! Mask selecting the `length` high-order bits
+    static uint32_t mask(const uint8_t length) { return length == 0 ? 0 : ~uint32_t(0) << (32 - length); }
+
+    //! The bit of `address` just after its first `length` bits
+    static size_t bit_after(const uint32_t address, const uint8_t length) { return (address >> (31 - length)) & 1; }
+
+    //! Number of leading bits shared by `a` and `b`, at most `limit`
+    static uint8_t common_length(const uint32_t a, const uint32_t b, const uint8_t limit) {
+        const uint32_t diff = a ^ b;
+        const uint8_t common = diff == 0 ? 32 : __builtin_clz(diff);
+        return common < limit ? common : limit;
+    }
+
+  public:
+    //! \brief Store `value` for `prefix`/`length`, replacing any value already stored for it
+    //! \note Bits of `prefix` past `length` are ignored.
+    void insert(uint32_t prefix, const uint8_t length, T value) {
+        prefix &= mask(length);
+        Node *node = _root.get();
+        while (node->length != length) {
+            std::unique_ptr<Node> &slot = node->child[bit_after(prefix, node->length)];
+            if (not slot) {
+                slot = std::make_unique<Node>(prefix, length);
+                slot->value = std::move(value);
+                ++_size;
+                ++_nodes;
+                return;
+            }
+
+            const uint8_t common = common_length(slot->prefix, prefix, std::min(slot->length, length));
+            if (common < slot->length) {
+                // split: the new prefix diverges from (or ends inside) the child's compressed path
+                auto middle = std::make_unique<Node>(prefix & mask(common), common);
+                middle->child[bit_after(slot->prefix, common)] = std::move(slot);
+                slot = std::move(middle);
+                ++_nodes;
+            }
+            node = slot.get();
+        }
+        if (not node->value) {
+            ++_size;
+        }
+        node->value = std::move(value);
+    }
+
+    //! \brief Remove the value stored for exactly `prefix`/`length`
+    //! \returns `true` if there was one
+    bool erase(uint32_t prefix, const uint8_t length) {
+        prefix &= mask(length);
+        std::unique_ptr<Node> *parent_slot = nullptr;
+        std::unique_ptr<Node> *slot = &_root;
+        while ((*slot)->length < length) {
+            std::unique_ptr<Node> &next = (*slot)->child[bit_after(prefix, (*slot)->length)];
+            if (not next or next->length > length or ((next->prefix ^ prefix) & mask(next->length)) != 0) {
+                return false;
+            }
+            parent_slot = slot;
+            slot = &next;
+        }
+        if ((*slot)->prefix != prefix or not(*slot)->value) {
+            return false;
+        }
+        (*slot)->value.reset();
+        --_size;
+
+        // keep the trie path-compressed: valueless nodes need two children (the root is exempt)
+        collapse(*slot);
+        if (parent_slot) {
+            collapse(*parent_slot);
+        }
+        return true;
+    }
+
+    //! \returns the value stored for exactly `prefix`/`length`, or nullptr
+    const T *find(uint32_t prefix, const uint8_t length) const {
+        prefix &= mask(length);
+        const Node *node = _root.get();
+        while (node and node->length < length and ((prefix ^ node->prefix) & mask(node->length)) == 0) {
+            node = node->child[bit_after(prefix, node->length)].get();
+        }
+        return node and node->length == length and node->prefix == prefix and node->value ? &node->value.value()
+                                                                                            : nullptr;
+    }
+
+    //! \returns the value stored for the longest prefix, no longer than `max_length`, that matches `address`,
+    //! or nullptr
+    const T *lookup(const uint32_t address, const uint8_t max_length = 32) const {
+        const T *best = nullptr;
+        const Node *node = _root.get();
+        while (node and node->length <= max_length and ((address ^ node->prefix) & mask(node->length)) == 0) {
+            if (node->value) {
+                best = &node->value.value();
+            }
+            if (node->length == 32) {
+                break;
+            }
+            node = node->child[bit_after(address, node->length)].get();
+        }
+        return best;
+    }
+
+    //! Number of prefixes stored
+    size_t size() const { return _size; }
+
+    //! Bytes used by the trie's nodes (not counting any memory owned by the values themselves)
+    size_t memory_usage() const { return sizeof(*this) + _nodes * sizeof(Node); }
+
+  private:
+    //! Remove or splice out the node in `slot` if it no longer carries a value and has at most one child
+    void collapse(std::unique_ptr<Node> &slot) {
+        if (slot == _root or slot->value or (slot->child[0] and slot->child[1])) {
+            return;
+        }
+        slot = std::move(slot->child[0] ? slot->child[0] : slot->child[1]);
+        --_nodes;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_PREFIX_TRIE_HH
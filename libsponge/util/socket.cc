@@ -2,8 +2,12 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
+#include <sys/uio.h>
 #include <unistd.h>
 
 using namespace std;
@@ -84,26 +88,44 @@ void Socket::shutdown(const int how) {
     }
 }
 
+//! \returns the size of each datagram the kernel merged into the one received with `header` (0: not merged)
+static size_t gro_size(msghdr &header) {
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO) {
+            int size;
+            memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            return size;
+        }
+    }
+    return 0;
+}
+
 //! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
 void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
     // receive source address and payload
     Address::Raw datagram_source_address;
     datagram.payload.resize(mtu);
 
-    socklen_t fromlen = sizeof(datagram_source_address);
+    iovec iov{datagram.payload.data(), mtu};
+    control_buffer control;
+    msghdr header{};
+    header.msg_name = static_cast<sockaddr *>(datagram_source_address);
+    header.msg_namelen = sizeof(datagram_source_address.storage);
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buf;
+    header.msg_controllen = sizeof(control.buf);
 
-    const ssize_t recv_len = SystemCall(
-        "recvfrom",
-        ::recvfrom(
-            fd_num(), datagram.payload.data(), datagram.payload.size(), MSG_TRUNC, datagram_source_address, &fromlen));
+    const ssize_t recv_len = SystemCall("recvmsg", ::recvmsg(fd_num(), &header, 0));
 
-    if (recv_len > ssize_t(mtu)) {
-        throw runtime_error("recvfrom (oversized datagram)");
+    if (header.msg_flags & MSG_TRUNC) {
+        throw runtime_error("recvmsg (oversized datagram)");
     }
 
     register_read();
-    datagram.source_address = {datagram_source_address, fromlen};
+    datagram.source_address = {datagram_source_address, header.msg_namelen};
     datagram.payload.resize(recv_len);
+    datagram.gro_size = gro_size(header);
 }
 
 UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
@@ -112,6 +134,50 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+//! \details Waits for the first datagram (unless `wait` is false), then takes whichever others have already
+//! arrived, without waiting. Each datagram's payload string is reused: it is sized to `mtu` to receive into, then
+//! to the datagram's length.
+//! \returns the number of datagrams received, at least one if `wait`; they are at the front of `datagrams`
+//! \note If `mtu` is too small to hold a received datagram, this method throws a std::runtime_error
+size_t UDPSocket::recv_batch(vector<received_datagram> &datagrams,
+                             const size_t count,
+                             const bool wait,
+                             const size_t mtu) {
+    const size_t n = min(count, datagrams.size());
+    _sources.resize(n);
+    _iovecs.resize(n);
+    _controls.resize(n);
+    _messages.assign(n, {});
+    for (size_t i = 0; i < n; i++) {
+        datagrams[i].payload.resize(mtu);
+        _iovecs[i] = {datagrams[i].payload.data(), mtu};
+        _messages[i].msg_hdr.msg_name = static_cast<sockaddr *>(_sources[i]);
+        _messages[i].msg_hdr.msg_namelen = sizeof(_sources[i].storage);
+        _messages[i].msg_hdr.msg_iov = &_iovecs[i];
+        _messages[i].msg_hdr.msg_iovlen = 1;
+        _messages[i].msg_hdr.msg_control = _controls[i].buf;
+        _messages[i].msg_hdr.msg_controllen = sizeof(_controls[i].buf);
+    }
+
+    const int flags = wait ? MSG_WAITFORONE : MSG_DONTWAIT;
+    const int received = SystemCall("recvmmsg", ::recvmmsg(fd_num(), _messages.data(), n, flags, nullptr), EAGAIN);
+    if (received < 0) {
+        return 0;
+    }
+
+    register_read();
+    for (int i = 0; i < received; i++) {
+        msghdr &header = _messages[i].msg_hdr;
+        if (header.msg_flags & MSG_TRUNC) {
+            throw runtime_error("recvmmsg (oversized datagram)");
+        }
+        datagrams[i].source_address = {_sources[i], header.msg_namelen};
+        datagrams[i].payload.resize(_messages[i].msg_len);
+        datagrams[i].gro_size = gro_size(header);
+    }
+    return received;
+}
+
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
@@ -136,6 +202,54 @@ void UDPSocket::sendto(const Address &destination, const BufferViewList &payload
     register_write();
 }
 
+//! \param[in] gso_sizes empty, or for each payload the size of the datagrams the kernel is to cut it into
+//! ([UDP_SEGMENT](\ref man7::udp)), with 0 meaning to send it whole
+//! \note sendmmsg() may send fewer datagrams than it was given, so this method calls it until all are sent.
+//! If a call fails, the batch_send_error it throws tells how many payloads had been sent.
+void UDPSocket::sendto_batch(const Address &destination,
+                             const vector<BufferViewList> &payloads,
+                             const vector<uint16_t> &gso_sizes) {
+    _iovecs.clear();
+    _controls.resize(gso_sizes.size());
+    _messages.assign(payloads.size(), {});
+    for (size_t i = 0; i < payloads.size(); i++) {
+        const size_t first = _iovecs.size();
+        payloads[i].append_iovecs(_iovecs);
+        _messages[i].msg_hdr.msg_iovlen = _iovecs.size() - first;
+    }
+
+    // now that _iovecs won't grow (and move), point each message at its own
+    for (size_t i = 0, first = 0; i < payloads.size(); first += _messages[i].msg_hdr.msg_iovlen, i++) {
+        _messages[i].msg_hdr.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+        _messages[i].msg_hdr.msg_namelen = destination.size();
+        _messages[i].msg_hdr.msg_iov = _iovecs.data() + first;
+        if (i < gso_sizes.size() and gso_sizes[i] != 0) {
+            _messages[i].msg_hdr.msg_control = _controls[i].buf;
+            _messages[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&_messages[i].msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(cmsg), &gso_sizes[i], sizeof(uint16_t));
+        }
+    }
+
+    for (size_t sent = 0; sent < _messages.size();) {
+        const size_t batch = min(_messages.size() - sent, size_t(UIO_MAXIOV));
+        const int n = ::sendmmsg(fd_num(), &_messages[sent], batch, 0);
+        if (n < 0) {
+            throw batch_send_error("sendmmsg", sent);
+        }
+        for (int i = 0; i < n; i++) {
+            if (_messages[sent + i].msg_len != payloads[sent + i].size()) {
+                throw runtime_error("datagram payload too big for sendmmsg()");
+            }
+        }
+        sent += n;
+    }
+    register_write();
+}
+
 void UDPSocket::send(const BufferViewList &payload) {
     sendmsg_helper(fd_num(), nullptr, 0, payload);
     register_write();
@@ -166,3 +280,11 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+//! \param[in] size the payload size of each datagram sent; the last of a payload may be shorter
+//! \note Throws a unix_error if the kernel doesn't support UDP GSO, so setting 0 tells whether it does
+void UDPSocket::set_gso_size(const uint16_t size) { setsockopt(SOL_UDP, UDP_SEGMENT, int(size)); }
+
+//! \details Merged datagrams come back from recv() and recv_batch() as one, with received_datagram::gro_size set.
+//! \note Throws a unix_error if the kernel doesn't support UDP GRO
+void UDPSocket::set_gro(const bool enabled) { setsockopt(SOL_UDP, UDP_GRO, int(enabled)); }
@@ -3,11 +3,14 @@
 
 #include "address.hh"
 #include "file_descriptor.hh"
+#include "util.hh"
 
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -49,6 +52,22 @@ class Socket : public FileDescriptor {
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
 class UDPSocket : public Socket {
+  private:
+    //! Room for the one control message UDPSocket uses, [UDP_GRO](\ref man7::udp) or [UDP_SEGMENT](\ref man7::udp)
+    union control_buffer {
+        char buf[CMSG_SPACE(sizeof(int))];
+        cmsghdr align;
+    };
+
+    //! \name Arguments of recv_batch()'s and sendto_batch()'s syscalls, kept between calls so that they are
+    //! allocated once
+    //!@{
+    std::vector<Address::Raw> _sources{};
+    std::vector<iovec> _iovecs{};
+    std::vector<control_buffer> _controls{};
+    std::vector<mmsghdr> _messages{};
+    //!@}
+
   protected:
     //! \brief Construct from FileDescriptor (used by TCPOverUDPSocketAdapter)
     //! \param[in] fd is the FileDescriptor from which to construct
@@ -62,6 +81,17 @@ class UDPSocket : public Socket {
     struct received_datagram {
         Address source_address;  //!< Address from which this datagram was received
         std::string payload;     //!< UDP datagram payload
+        size_t gro_size = 0;     //!< With set_gro(), the size of each datagram merged into `payload` (0: not merged)
+    };
+
+    //! Thrown by sendto_batch(): the error from [sendmmsg(2)](\ref man2::sendmmsg), and how far it had got
+    class batch_send_error : public unix_error {
+      public:
+        size_t sent;  //!< Number of payloads sent before the error
+
+        //! Construct from the syscall attempted, the payloads already sent, and the resulting errno
+        batch_send_error(const std::string &attempt, const size_t sent_before, const int error = errno)
+            : unix_error(attempt, error), sent(sent_before) {}
     };
 
     //! Receive a datagram and the Address of its sender
@@ -70,11 +100,36 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Receive up to `count` datagrams with one [recvmmsg(2)](\ref man2::recvmmsg), into the caller's storage
+    size_t recv_batch(std::vector<received_datagram> &datagrams,
+                      const size_t count,
+                      const bool wait = true,
+                      const size_t mtu = 65536);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
+    //! Send each of `payloads` as a datagram to specified Address, with as few [sendmmsg(2)](\ref man2::sendmmsg)
+    //! calls as possible; a payload with a nonzero entry in `gso_sizes` is cut into datagrams of that size
+    void sendto_batch(const Address &destination,
+                      const std::vector<BufferViewList> &payloads,
+                      const std::vector<uint16_t> &gso_sizes = {});
+
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+    //! Have the kernel cut every datagram sent into datagrams of `size` bytes ([UDP_SEGMENT](\ref man7::udp));
+    //! 0 turns this off
+    void set_gso_size(const uint16_t size);
+
+    //! Have the kernel merge arriving datagrams of a flow into one ([UDP_GRO](\ref man7::udp))
+    void set_gro(const bool enabled);
+
+    //! The largest payload of one send: a datagram, or the whole of one the kernel cuts up
+    static constexpr size_t MAX_PAYLOAD = 65507;
+
+    //! The most datagrams the kernel will cut one payload into
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;
 };
 
 //! \class UDPSocket
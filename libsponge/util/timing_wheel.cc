@@ -0,0 +1,214 @@
+#include "timing_wheel.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+TimingWheel::TimingWheel() { _slots.fill(NIL); }
+
+const TimingWheel::Node *TimingWheel::find(const TimerID id) const {
+    const uint32_t index = id & UINT32_MAX;
+    if (index >= _nodes.size()) {
+        return nullptr;
+    }
+    const Node &node = _nodes[index];
+    return node.generation == id >> 32 and node.where < CANCELED ? &node : nullptr;
+}
+
+uint32_t TimingWheel::allocate() {
+    if (_free_head == NIL) {
+        if (_nodes.size() >= NIL) {
+            throw length_error("TimingWheel: too many timers");
+        }
+        _nodes.emplace_back();
+        return _nodes.size() - 1;
+    }
+    const uint32_t index = _free_head;
+    _free_head = _nodes[index].next;
+    return index;
+}
+
+void TimingWheel::release(const uint32_t index) {
+    Node &node = _nodes[index];
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    node.where = FREE;
+    node.next = _free_head;
+    _free_head = index;
+}
+
+void TimingWheel::file(const uint32_t index) {
+    Node &node = _nodes[index];
+    const uint64_t delta = node.deadline > _now ? node.deadline - _now : 0;
+    if (delta == 0) {
+        node.where = DUE;
+        _due.push_back(index);
+        return;
+    }
+
+    // level l takes deltas in [64^l, 64^(l+1)); anything further out waits in the top level's
+    // slot just behind the current one, the last to come round
+    const size_t level = (63 - __builtin_clzll(delta)) / SLOT_BITS;
+    size_t slot;
+    if (level < LEVELS) {
+        slot = level * SLOTS + ((node.deadline >> (level * SLOT_BITS)) & (SLOTS - 1));
+    } else {
+        constexpr size_t top = (LEVELS - 1) * SLOT_BITS;
+        slot = (LEVELS - 1) * SLOTS + (((_now >> top) + SLOTS - 1) & (SLOTS - 1));
+    }
+
+    node.where = slot;
+    node.prev = NIL;
+    node.next = _slots[slot];
+    if (node.next != NIL) {
+        _nodes[node.next].prev = index;
+    }
+    _slots[slot] = index;
+    _occupied[slot / SLOTS] |= uint64_t(1) << (slot % SLOTS);
+}
+
+void TimingWheel::unlink(const uint32_t index) {
+    const Node &node = _nodes[index];
+    if (node.prev == NIL) {
+        _slots[node.where] = node.next;
+        if (node.next == NIL) {
+            _occupied[node.where / SLOTS] &= ~(uint64_t(1) << (node.where % SLOTS));
+        }
+    } else {
+        _nodes[node.prev].next = node.next;
+    }
+    if (node.next != NIL) {
+        _nodes[node.next].prev = node.prev;
+    }
+}
+
+void TimingWheel::cascade(const size_t level, const size_t slot) {
+    uint32_t index = _slots[level * SLOTS + slot];
+    _slots[level * SLOTS + slot] = NIL;
+    _occupied[level] &= ~(uint64_t(1) << slot);
+    while (index != NIL) {
+        const uint32_t next = _nodes[index].next;
+        file(index);
+        index = next;
+    }
+}
+
+TimingWheel::TimerID TimingWheel::arm(const uint64_t delay_ms, const uint64_t token) {
+    const uint32_t index = allocate();
+    Node &node = _nodes[index];
+    node.deadline = _now + delay_ms;
+    node.token = token;
+    file(index);
+    ++_size;
+    return TimerID{node.generation} << 32 | index;
+}
+
+bool TimingWheel::cancel(const TimerID id) {
+    if (not find(id)) {
+        return false;
+    }
+    const uint32_t index = id & UINT32_MAX;
+    --_size;
+    if (_nodes[index].where == DUE) {
+        // still in `_due`; advance() frees it when it gets there
+        _nodes[index].where = CANCELED;
+        ++_nodes[index].generation;
+        return true;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+optional<uint64_t> TimingWheel::time_left(const TimerID id) const {
+    const Node *node = find(id);
+    if (not node) {
+        return {};
+    }
+    return node->deadline > _now ? node->deadline - _now : 0;
+}
+
+void TimingWheel::advance(const uint64_t ms, const function<void(uint64_t token)> &expired) {
+    const uint64_t target = _now + ms;
+    while (_now < target) {
+        // the next instant anything can happen: the soonest time a non-empty slot of any level comes
+        // round, which for level l is a multiple of 64^l; the empty slots in between are skipped
+        uint64_t next = UINT64_MAX;
+        for (size_t level = 0; level < LEVELS; level++) {
+            const uint64_t bits = _occupied[level];
+            if (bits == 0) {
+                continue;
+            }
+            const unsigned width = level * SLOT_BITS;
+            const uint64_t boundary = ((_now >> width) + 1) << width;
+            const unsigned shift = (boundary >> width) & (SLOTS - 1);
+            const uint64_t ahead = shift == 0 ? bits : bits >> shift | bits << (SLOTS - shift);
+            next = min(next, boundary + (uint64_t(__builtin_ctzll(ahead)) << width));
+        }
+        if (next > target) {
+            _now = target;
+            break;
+        }
+        _now = next;
+
+        // each level whose position just wrapped pulls down the current slot of the level above
+        for (size_t level = 1; level < LEVELS and (_now & ((uint64_t(1) << (level * SLOT_BITS)) - 1)) == 0;
+             level++) {
+            cascade(level, (_now >> (level * SLOT_BITS)) & (SLOTS - 1));
+        }
+        cascade(0, _now & (SLOTS - 1));
+    }
+
+    // report after the clock has moved, so timers re-armed by `expired` count from the new time
+    vector<uint32_t> due;
+    swap(due, _due);
+    for (const uint32_t index : due) {
+        const bool canceled = _nodes[index].where == CANCELED;
+        const uint64_t token = _nodes[index].token;
+        if (not canceled) {
+            --_size;
+        }
+        release(index);
+        if (not canceled) {
+            expired(token);
+        }
+    }
+    if (_due.empty()) {
+        due.clear();
+        swap(due, _due);
+    }
+}
+
+WheelTimer::WheelTimer(shared_ptr<TimingWheel> wheel, const uint64_t token) : _wheel(move(wheel)), _token(token) {
+    if (not _wheel) {
+        throw invalid_argument("WheelTimer: no TimingWheel");
+    }
+}
+
+WheelTimer::WheelTimer(WheelTimer &&other) noexcept
+    : _wheel(other._wheel), _token(other._token), _id(exchange(other._id, 0)) {}
+
+WheelTimer &WheelTimer::operator=(WheelTimer &&other) noexcept {
+    if (this != &other) {
+        stop();
+        _wheel = other._wheel;
+        _token = other._token;
+        _id = exchange(other._id, 0);
+    }
+    return *this;
+}
+
+void WheelTimer::start(const uint64_t delay_ms) {
+    stop();
+    _id = _wheel->arm(delay_ms, _token);
+}
+
+void WheelTimer::stop() {
+    if (_id) {
+        _wheel->cancel(_id);
+        _id = 0;
+    }
+}
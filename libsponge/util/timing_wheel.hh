@@ -0,0 +1,133 @@
+#ifndef SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: millisecond timers that are armed, canceled and expired in O(1).
+//!
+//! Level `l` of the wheel has 64 slots and holds the timers due between 64^l and 64^(l+1) ms from now,
+//! each in the slot picked by bits [6l, 6l + 6) of its deadline. Whenever the position in one level
+//! wraps around, the current slot of the level above is cascaded down into the finer levels. Timers
+//! more than 2^24 ms away wait in the top level and are filed again each time their slot comes round.
+//! Per-level occupancy bitmaps let advance() jump straight to the next non-empty slot of any level, so
+//! skipping an empty stretch of time costs O(levels) however long it is.
+//!
+//! A timer carries an opaque `token` rather than a callback: advance() hands the tokens of expired
+//! timers to its caller, who decides what each one means. That way the objects a timer belongs to
+//! can move around in memory while the timer is armed.
+class TimingWheel {
+  public:
+    using TimerID = uint64_t;  //!< Identifies an armed timer; 0 never does
+
+  private:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // where a node is: a slot (level * SLOTS + slot), or one of these
+    static constexpr uint16_t DUE = LEVELS * SLOTS;  //!< expired, waiting to be reported
+    static constexpr uint16_t CANCELED = DUE + 1;    //!< canceled while due
+    static constexpr uint16_t FREE = DUE + 2;        //!< unused
+
+    struct Node {
+        uint64_t deadline = 0;
+        uint64_t token = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 1;  //!< bumped when the node is freed, so stale TimerIDs don't match
+        uint16_t where = FREE;
+    };
+
+    uint64_t _now = 0;
+    size_t _size = 0;
+    std::vector<Node> _nodes{};
+    uint32_t _free_head = NIL;
+    std::array<uint32_t, LEVELS * SLOTS> _slots{};  //!< Head of each slot's list
+    std::array<uint64_t, LEVELS> _occupied{};       //!< Which slots of each level are non-empty
+    std::vector<uint32_t> _due{};                   //!< Expired nodes, in order of expiry
+
+    //! The node `id` refers to, if it is still armed
+    const Node *find(const TimerID id) const;
+
+    uint32_t allocate();
+    void release(const uint32_t index);
+
+    //! Put node `index` in the slot (or the due list) that matches its deadline
+    void file(const uint32_t index);
+    void unlink(const uint32_t index);
+    //! Re-file every node in slot `slot` of `level`
+    void cascade(const size_t level, const size_t slot);
+
+  public:
+    TimingWheel();
+
+    //! Milliseconds the wheel has been advanced since it was created
+    uint64_t now() const { return _now; }
+
+    //! Number of timers armed
+    size_t size() const { return _size; }
+
+    //! \brief Arm a timer that expires `delay_ms` milliseconds from now()
+    //! \note A timer armed with no delay expires on the next call to advance(), even an advance by 0 ms.
+    TimerID arm(const uint64_t delay_ms, const uint64_t token);
+
+    //! \brief Disarm a timer
+    //! \returns `true` if it was still armed
+    bool cancel(const TimerID id);
+
+    //! Milliseconds until the timer expires, if it is still armed
+    std::optional<uint64_t> time_left(const TimerID id) const;
+
+    //! \brief Move the clock forward by `ms` and report every timer that expired
+    //! \details `expired` is called with each expired timer's token, in order of expiry, after the clock
+    //! has reached its new time; it may arm and cancel timers but must not advance the wheel.
+    void advance(const uint64_t ms, const std::function<void(uint64_t token)> &expired);
+};
+
+//! \brief A timer for one owner on a (possibly shared) TimingWheel, disarmed when it is destroyed
+//! \details The wheel is shared so that it outlives every timer on it, whatever order their owners go in.
+class WheelTimer {
+  private:
+    std::shared_ptr<TimingWheel> _wheel;
+    uint64_t _token;
+    TimingWheel::TimerID _id = 0;
+
+  public:
+    //! A stopped timer that reports `token` to whoever advances `wheel`
+    WheelTimer(std::shared_ptr<TimingWheel> wheel, const uint64_t token);
+    ~WheelTimer() { stop(); }
+
+    WheelTimer(WheelTimer &&other) noexcept;
+    WheelTimer &operator=(WheelTimer &&other) noexcept;
+    WheelTimer(const WheelTimer &other) = delete;
+    WheelTimer &operator=(const WheelTimer &other) = delete;
+
+    //! (Re)start the timer so that it expires `delay_ms` from now
+    void start(const uint64_t delay_ms);
+
+    //! Stop the timer if it is running
+    void stop();
+
+    //! Is the timer armed?
+    bool running() const { return time_left().has_value(); }
+
+    //! Milliseconds until the timer expires, if it is armed
+    std::optional<uint64_t> time_left() const { return _id ? _wheel->time_left(_id) : std::nullopt; }
+
+    TimingWheel &wheel() { return *_wheel; }
+    const TimingWheel &wheel() const { return *_wheel; }
+    //! The wheel itself, for arming other timers on it
+    const std::shared_ptr<TimingWheel> &shared_wheel() const { return _wheel; }
+
+    //! The token the timer reports when it expires
+    uint64_t token() const { return _token; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMING_WHEEL_HH
@@ -3,11 +3,18 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPONGE_CHECKSUM_X86 1
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -69,6 +76,112 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+//! \name Checksum kernels
+//! Each kernel sums the even-length `data` as native-order 32-bit words into a 64-bit total.
+//! Because the ones'-complement sum is independent of byte order (RFC 1071
+//! section 2), folding that total to 16 bits and byte-swapping it on a little-endian host gives
+//! the sum of the big-endian 16-bit words.
+//!@{
+
+static uint64_t checksum_portable(const char *data, size_t len) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += (word & 0xffffffff) + (word >> 32);
+    }
+    if (len >= 4) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += word;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
+#ifdef SPONGE_CHECKSUM_X86
+[[gnu::target("sse2")]] static uint64_t checksum_sse2(const char *data, size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; len >= 16; data += 16, len -= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+    }
+    alignas(16) array<uint64_t, 2> lanes{};
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes.data()), acc);
+    return lanes[0] + lanes[1] + checksum_portable(data, len);
+}
+
+[[gnu::target("avx2")]] static uint64_t checksum_avx2(const char *data, size_t len) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (; len >= 32; data += 32, len -= 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+    }
+    alignas(32) array<uint64_t, 4> lanes{};
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + checksum_sse2(data, len);
+}
+#endif
+//!@}
+
+using ChecksumKernel = uint64_t (*)(const char *, size_t);
+
+//! The kernels the running CPU supports, widest first
+static const vector<pair<ChecksumKernel, const char *>> &supported_checksum_kernels() {
+    static const auto kernels = [] {
+        vector<pair<ChecksumKernel, const char *>> supported;
+#ifdef SPONGE_CHECKSUM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            supported.emplace_back(checksum_avx2, "avx2");
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            supported.emplace_back(checksum_sse2, "sse2");
+        }
+#endif
+        supported.emplace_back(checksum_portable, "portable");
+        return supported;
+    }();
+    return kernels;
+}
+
+//! The kernel add() uses: the widest one, unless set_implementation() picked another
+static pair<ChecksumKernel, const char *> &checksum_kernel() {
+    static auto kernel = supported_checksum_kernels().front();
+    return kernel;
+}
+
+const char *InternetChecksum::implementation() { return checksum_kernel().second; }
+
+vector<const char *> InternetChecksum::implementations() {
+    vector<const char *> names;
+    for (const auto &kernel : supported_checksum_kernels()) {
+        names.push_back(kernel.second);
+    }
+    return names;
+}
+
+//! \param[in] name is one of implementations(); throws std::invalid_argument otherwise
+void InternetChecksum::set_implementation(const string &name) {
+    for (const auto &kernel : supported_checksum_kernels()) {
+        if (name == kernel.second) {
+            checksum_kernel() = kernel;
+            return;
+        }
+    }
+    throw invalid_argument("InternetChecksum: no \"" + name + "\" kernel on this CPU");
+}
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -86,19 +199,36 @@ mt19937 get_random_generator() {
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
+//! \details The checksum is taken over big-endian 16-bit words, so a previous call that ended
+//! on an odd byte leaves `_parity` set and the next byte is the low half of that word.
 void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
-        }
-        _sum += val;
-        _parity = !_parity;
+    if (data.empty()) {
+        return;
+    }
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    const size_t even_len = data.size() & ~size_t(1);
+    uint64_t sum = checksum_kernel().first(data.data(), even_len);
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    sum = ((sum & 0xff) << 8) | (sum >> 8);
+#endif
+    _sum += sum;
+
+    if (even_len != data.size()) {
+        _sum += uint16_t(uint8_t(data.back()) << 8);
+        _parity = true;
     }
 }
 
 uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+    uint64_t ret = _sum;
 
     while (ret > 0xffff) {
         ret = (ret >> 16) + (ret & 0xffff);
@@ -107,6 +237,18 @@ uint16_t InternetChecksum::value() const {
     return ~ret;
 }
 
+//! \param[in] checksum is the checksum before the change
+//! \param[in] old_word is the 16-bit word (in host order) before the change
+//! \param[in] new_word is the 16-bit word (in host order) after the change
+uint16_t InternetChecksum::adjust(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word) {
+    // HC' = ~(~HC + ~m + m')
+    uint32_t sum = uint16_t(~checksum) + uint16_t(~old_word) + uint32_t(new_word);
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
 //! \param[in] data is a pointer to the bytes to show
 //! \param[in] len is the number of bytes to show
 //! \param[in] indent is the number of spaces to indent
@@ -54,13 +54,31 @@ uint64_t timestamp_ms();
 //! The internet checksum algorithm
 class InternetChecksum {
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
+
+    //! \brief Add bytes to the checksum; may be called repeatedly with arbitrary (even odd-length) pieces
+    //! \note Sums 8, 16 or 32 bytes per step, using the widest kernel this CPU supports
     void add(std::string_view data);
+
     uint16_t value() const;
+
+    //! \brief Update a checksum after one 16-bit word of the checksummed data changed
+    //! \returns the new checksum, computed incrementally as in RFC 1624 (eqn. 3)
+    static uint16_t adjust(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word);
+
+    //! \brief Name of the kernel that add() selected at runtime ("avx2", "sse2" or "portable")
+    static const char *implementation();
+
+    //! \brief Names of the kernels this CPU can run, widest first
+    static std::vector<const char *> implementations();
+
+    //! \brief Make add() use the kernel named `name`, e.g. to test or benchmark it
+    //! \note Not thread-safe: switch kernels only while nothing else is checksumming
+    static void set_implementation(const std::string &name);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
@@ -0,0 +1,102 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"chunked write-write-pop-peek", 15, ByteStream::Storage::Chunked};
+
+            test.execute(Write{"cat"});
+            test.execute(Write{"tac"});
+
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"cattac"});
+
+            test.execute(Pop{2});
+
+            test.execute(BytesRead{2});
+            test.execute(BufferSize{4});
+            test.execute(Peek{"ttac"});
+
+            test.execute(Pop{3});
+            test.execute(EndInput{});
+
+            test.execute(BufferSize{1});
+            test.execute(Peek{"c"});
+            test.execute(Eof{false});
+
+            test.execute(Pop{1});
+
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked overwrite", 2, ByteStream::Storage::Chunked};
+
+            test.execute(Write{"cat"}.with_bytes_written(2));
+            test.execute(Pop{1});
+            test.execute(Write{"tac"}.with_bytes_written(1));
+
+            test.execute(BytesRead{1});
+            test.execute(BytesWritten{3});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"at"});
+        }
+
+        {
+            ByteStream stream{100, ByteStream::Storage::Chunked};
+            Buffer owned{string("0123456789")};
+            const char *const owned_data = owned.str().data();
+
+            if (stream.write(owned) != 10 or stream.write(string("abcdef")) != 6) {
+                throw runtime_error("chunked write accepted wrong number of bytes");
+            }
+
+            // reads within one chunk share storage with the written Buffer
+            const Buffer first = stream.read_buffer(4);
+            if (first.str() != "0123" or first.str().data() != owned_data) {
+                throw runtime_error("read_buffer within a chunk did not return a slice of the written Buffer");
+            }
+
+            // reads that span chunks fall back to a copy
+            const Buffer spanning = stream.read_buffer(8);
+            if (spanning.str() != "456789ab") {
+                throw runtime_error("read_buffer across chunks returned \"" + spanning.copy() + "\"");
+            }
+
+            if (stream.peek_output_views(100).size() != 4 or stream.read(4) != "cdef" or not stream.buffer_empty()) {
+                throw runtime_error("chunked stream did not drain cleanly");
+            }
+        }
+
+        {
+            ByteStream stream{4};
+            stream.write("abcd");
+            stream.pop_output(2);
+            stream.write("ef");
+
+            // the ring wraps around, so the views are split in two
+            const auto iovecs = stream.peek_output_views(4).as_iovecs();
+            if (iovecs.size() != 2 or iovecs[0].iov_len != 2 or iovecs[1].iov_len != 2 or
+                stream.peek_output(4) != "cdef") {
+                throw runtime_error("peek_output_views over a wrapped ring buffer returned wrong views");
+            }
+        }
+
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -45,11 +45,14 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Storage storage)
+    : _test_name(test_name), _byte_stream(capacity, storage) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", storage=" << (storage == ByteStream::Storage::Ring ? "ring" : "chunked")
+       << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
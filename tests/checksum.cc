@@ -0,0 +1,87 @@
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//! The RFC 1071 checksum, one big-endian 16-bit word at a time (an odd last byte is padded with zero)
+static uint16_t reference_checksum(const string_view data) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.size(); i += 2) {
+        sum += uint16_t(uint8_t(data[i]) << 8) + (i + 1 < data.size() ? uint8_t(data[i + 1]) : 0);
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+static uint16_t checksum(const string_view data) {
+    InternetChecksum check;
+    check.add(data);
+    return check.value();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        string random(32 + 65536, 0);
+        for (auto &ch : random) {
+            ch = rd();
+        }
+        const string ones(32 + 65536, '\xff');
+
+        for (const char *kernel : InternetChecksum::implementations()) {
+            InternetChecksum::set_implementation(kernel);
+
+            // every length at every alignment a vector load can see, on random bytes and on all-ones bytes
+            for (const string_view data : {string_view(random), string_view(ones)}) {
+                for (size_t offset = 0; offset < 32; offset++) {
+                    for (size_t len = 0; len <= 300; len++) {
+                        const string_view view = data.substr(offset, len);
+                        test_err_if(checksum(view) != reference_checksum(view),
+                                    string(kernel) + ": wrong checksum of " + to_string(len) + " bytes at offset " +
+                                        to_string(offset));
+                    }
+                }
+                // long inputs, so that the wide accumulators carry many times over
+                const string_view view = data.substr(1);
+                test_err_if(checksum(view) != reference_checksum(view),
+                            string(kernel) + ": wrong checksum of a long input");
+            }
+
+            // pieces of any length, including odd ones, add up to the checksum of the whole
+            for (size_t cut = 0; cut <= 300; cut++) {
+                const string_view view = string_view(random).substr(0, 300);
+                InternetChecksum check;
+                check.add(view.substr(0, cut));
+                check.add(view.substr(cut));
+                test_err_if(check.value() != reference_checksum(view),
+                            string(kernel) + ": wrong checksum when cut at " + to_string(cut));
+            }
+        }
+
+        // adjust() agrees with checksumming the changed data again
+        string data = random.substr(0, 64);
+        for (unsigned i = 0; i < 10000; i++) {
+            const size_t at = 2 * (rd() % (data.size() / 2));
+            const uint16_t old_word = uint8_t(data[at]) << 8 | uint8_t(data[at + 1]);
+            const uint16_t new_word = i % 3 == 0 ? ~old_word : rd();
+            const uint16_t before = reference_checksum(data);
+            data[at] = new_word >> 8;
+            data[at + 1] = new_word & 0xff;
+            const uint16_t adjusted = InternetChecksum::adjust(before, old_word, new_word);
+            test_err_if(adjusted != reference_checksum(data),
+                        "adjust() disagrees with a full recompute after change " + to_string(i));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
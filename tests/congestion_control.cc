@@ -0,0 +1,141 @@
+#include "congestion_control.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Acknowledge `bytes` one MSS at a time
+static void ack(CongestionControl &cc, size_t bytes, uint64_t now) {
+    for (; bytes > 0; bytes -= MSS) {
+        cc.on_ack(MSS, 0, now);
+    }
+}
+
+int main() {
+    try {
+        test_err_if(CongestionControl::make(TCPConfig::Congestion::None, MSS) != nullptr, "None made a controller");
+
+        // NewReno: slow start doubles cwnd per window, loss halves it, then one MSS per window
+        {
+            auto cc = CongestionControl::make(TCPConfig::Congestion::NewReno, MSS);
+            test_err_if(cc->cwnd() != 10 * MSS, "initial window is not 10 segments");
+            ack(*cc, 10 * MSS, 0);
+            test_err_if(cc->cwnd() != 20 * MSS, "slow start did not double the window");
+            cc->on_loss(20 * MSS, 0);
+            test_err_if(cc->cwnd() != 10 * MSS or cc->ssthresh() != 10 * MSS, "loss did not halve the window");
+            ack(*cc, 10 * MSS, 0);
+            test_err_if(cc->cwnd() != 11 * MSS, "congestion avoidance did not add one MSS per window");
+            cc->on_timeout(11 * MSS, 0);
+            test_err_if(cc->cwnd() != MSS or cc->ssthresh() != 5500, "timeout did not collapse the window");
+            ack(*cc, 10 * MSS, 0);
+            test_err_if(cc->cwnd() != 5500 + MSS, "slow start did not hand over to congestion avoidance at ssthresh");
+            cc->on_loss(MSS, 0);
+            test_err_if(cc->ssthresh() != 2 * MSS, "ssthresh fell below two segments");
+        }
+
+        // CUBIC: backs off by 30%, then regains the old window after K seconds and probes beyond it
+        {
+            auto cc = CongestionControl::make(TCPConfig::Congestion::Cubic, MSS);
+            ack(*cc, 90 * MSS, 0);
+            test_err_if(cc->cwnd() != 100 * MSS, "slow start did not grow the window");
+            cc->on_loss(100 * MSS, 0);
+            test_err_if(cc->cwnd() != 70 * MSS, "loss did not cut the window to 70%");
+
+            // K = cbrt(100 * 0.3 / 0.4) ~= 4.2 s; ack a window's worth every 100 ms
+            uint64_t now = 0;
+            size_t at_2s = 0;
+            for (; now <= 6000; now += 100) {
+                ack(*cc, cc->cwnd(), now);
+                if (now == 2000) {
+                    at_2s = cc->cwnd();
+                }
+            }
+            test_err_if(at_2s <= 70 * MSS or at_2s >= 100 * MSS,
+                        "window not between the cut and the old maximum at 2 s");
+            test_err_if(cc->cwnd() <= 100 * MSS, "window did not grow past the old maximum");
+
+            cc->on_timeout(cc->cwnd(), now);
+            test_err_if(cc->cwnd() != MSS, "timeout did not collapse the window");
+        }
+
+        // the sender keeps no more than cwnd in flight, and a timeout shrinks that to one segment
+        {
+            TCPConfig cfg;
+            cfg.congestion_control = TCPConfig::Congestion::NewReno;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(50000, 'x'));
+            sender.fill_window();
+            const CongestionControl &cc = *sender.congestion_control();
+            test_err_if(sender.bytes_in_flight() != cc.cwnd() or cc.cwnd() <= 10 * MSS,
+                        "sender did not fill the congestion window");
+            sender.tick(cfg.rt_timeout);
+            const size_t ssthresh = cc.ssthresh();
+            test_err_if(cc.cwnd() != MSS or ssthresh != sender.bytes_in_flight() / 2,
+                        "timeout did not reach the congestion controller");
+            sender.tick(2 * cfg.rt_timeout);
+            test_err_if(sender.consecutive_retransmissions() != 2 or cc.ssthresh() != ssthresh,
+                        "repeated timeout lowered ssthresh again");
+        }
+
+        // three duplicate ACKs retransmit the oldest segment at once, then fast recovery keeps data flowing
+        {
+            TCPConfig cfg;
+            cfg.congestion_control = TCPConfig::Congestion::NewReno;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(20000, 'x'));
+            sender.fill_window();
+            sender.segments_out() = {};
+            const CongestionControl &cc = *sender.congestion_control();
+            const size_t flight = sender.bytes_in_flight();
+            test_err_if(flight != cc.cwnd(), "initial window not sent");
+
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_err_if(not sender.segments_out().empty(), "retransmitted after two duplicate ACKs");
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_err_if(sender.segments_out().empty() or
+                            sender.segments_out().front().header().seqno != WrappingInt32{1},
+                        "third duplicate ACK did not retransmit the oldest segment");
+            test_err_if(sender.consecutive_retransmissions() != 0, "fast retransmit counted as a timeout");
+            test_err_if(cc.ssthresh() != flight / 2, "fast retransmit did not halve ssthresh");
+            sender.segments_out() = {};
+
+            // each further duplicate means a segment has left the network, so the window lets a new one out
+            for (size_t i = 0; i < 3; i++) {
+                sender.ack_received(WrappingInt32{1}, 60000);
+            }
+            test_err_if(sender.bytes_in_flight() <= flight, "fast recovery did not send new data");
+            test_err_if(cc.cwnd() != flight / 2, "duplicate ACKs grew cwnd during recovery");
+
+            // a segment carrying data is never a duplicate ACK
+            sender.segments_out() = {};
+            sender.ack_received(WrappingInt32{1}, 60000, true);
+            test_err_if(not sender.segments_out().empty(), "data segment counted as a duplicate ACK");
+
+            // a partial ACK retransmits the next hole; a full ACK ends recovery with cwnd at ssthresh
+            sender.ack_received(WrappingInt32{1 + MSS}, 60000);
+            test_err_if(sender.segments_out().empty() or
+                            sender.segments_out().front().header().seqno != WrappingInt32{1 + MSS},
+                        "partial ACK did not retransmit the next segment");
+            sender.ack_received(sender.next_seqno(), 60000);
+            test_err_if(cc.cwnd() != cc.ssthresh() or cc.ssthresh() != flight / 2, "full ACK did not end recovery");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
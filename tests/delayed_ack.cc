@@ -0,0 +1,105 @@
+#include "tcp_connection.hh"
+#include "test_err_if.hh"
+#include "test_utils_tcp_connection.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPConfig config(const uint16_t ack_delay) {
+    TCPConfig cfg;
+    cfg.ack_delay = ack_delay;
+    return cfg;
+}
+
+//! Two connections that have finished the handshake
+struct Pair {
+    TCPConnection a, b;
+
+    explicit Pair(const TCPConfig &cfg) : a{cfg}, b{cfg} {
+        a.connect();
+        deliver(a, b);
+        test_err_if(deliver(b, a).size() != 1, "SYN-ACK delayed");
+        test_err_if(deliver(a, b).size() != 1, "ACK of the SYN-ACK delayed");
+    }
+};
+
+int main() {
+    try {
+        // without ack_delay every segment is acknowledged at once
+        {
+            Pair p{config(0)};
+            p.a.write(string(4 * MSS, 'x'));
+            deliver(p.a, p.b);
+            test_err_if(take(p.b).size() != 4, "segments not acknowledged one by one");
+        }
+
+        // a lone segment is acknowledged when the delay runs out
+        {
+            Pair p{config(40)};
+            p.a.write(string(100, 'x'));
+            deliver(p.a, p.b);
+            test_err_if(not p.b.segments_out().empty(), "ACK not delayed");
+            test_err_if(p.b.time_until_next_timeout() != 40, "delayed ACK not scheduled");
+            p.b.tick(39);
+            test_err_if(not p.b.segments_out().empty(), "delayed ACK sent early");
+            p.b.tick(1);
+            const auto acks = deliver(p.b, p.a);
+            test_err_if(acks.size() != 1 or p.a.bytes_in_flight() != 0, "delayed ACK not sent");
+            test_err_if(p.b.time_until_next_timeout().has_value(), "timer left running");
+        }
+
+        // every second full segment is acknowledged at once
+        {
+            Pair p{config(40)};
+            p.a.write(string(6 * MSS, 'x'));
+            deliver(p.a, p.b);
+            const auto acks = deliver(p.b, p.a);
+            test_err_if(acks.size() != 3, "full segments not acknowledged in pairs");
+            test_err_if(p.a.bytes_in_flight() != 0, "last pair not acknowledged");
+            test_err_if(p.b.time_until_next_timeout().has_value(), "timer left running after the last ACK");
+        }
+
+        // out-of-order data, the segment that fills the hole and the FIN are acknowledged at once
+        {
+            Pair p{config(40)};
+            p.a.write(string(3 * MSS, 'x'));
+            auto segs = take(p.a);
+            p.b.segment_received(segs[1]);
+            test_err_if(take(p.b).size() != 1, "out-of-order segment not acknowledged at once");
+            p.b.segment_received(segs[2]);
+            test_err_if(take(p.b).size() != 1, "out-of-order segment not acknowledged at once");
+            p.b.segment_received(segs[0]);
+            const auto acks = take(p.b);
+            test_err_if(acks.size() != 1 or acks[0].header().ackno != segs[2].header().seqno + MSS,
+                        "segment filling the hole not acknowledged at once");
+
+            p.a.end_input_stream();
+            deliver(p.a, p.b);
+            test_err_if(take(p.b).size() != 1, "FIN not acknowledged at once");
+        }
+
+        // data sent in the other direction carries the ACK, and the delayed ACK is dropped
+        {
+            Pair p{config(40)};
+            p.a.write(string(100, 'x'));
+            deliver(p.a, p.b);
+            p.b.write("reply");
+            const auto segs = deliver(p.b, p.a);
+            test_err_if(segs.size() != 1 or segs[0].payload().size() != 5 or p.a.bytes_in_flight() != 0,
+                        "reply did not carry the ACK");
+            p.b.tick(40);
+            test_err_if(not p.b.segments_out().empty(), "delayed ACK sent after a piggybacked one");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
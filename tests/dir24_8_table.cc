@@ -0,0 +1,76 @@
+#include "dir24_8_table.hh"
+#include "prefix_trie.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static uint32_t mask(const uint8_t length) { return length == 0 ? 0 : ~uint32_t(0) << (32 - length); }
+
+static void check(const Dir24_8Table<int> &table, const PrefixTrie<int> &trie, const uint32_t address) {
+    const int *actual = table.lookup(address);
+    const int *expected = trie.lookup(address);
+    if ((actual ? *actual : -1) != (expected ? *expected : -1)) {
+        throw runtime_error("lookup of " + to_string(address) + " returned " + to_string(actual ? *actual : -1) +
+                            ", expected " + to_string(expected ? *expected : -1));
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        Dir24_8Table<int> table;
+        if (table.memory_usage() < (size_t(1) << 24) * sizeof(uint32_t)) {
+            throw runtime_error("memory_usage() does not account for the first-level table");
+        }
+
+        // prefixes of every length clustered in a few /16s, so they nest inside each other and inside /24s
+        for (unsigned round = 0; round < 4; round++) {
+            PrefixTrie<int> trie;
+            vector<pair<uint32_t, uint8_t>> installed;
+            const uint32_t base = rd() & 0xfffc0000;
+            for (int i = 0; i < 3000; i++) {
+                if (installed.empty() or rd() % 3 != 0) {
+                    // mostly lengths from /12 up, with the occasional short prefix or default route
+                    const uint8_t length = rd() % 16 == 0 ? rd() % 12 : 12 + rd() % 21;
+                    const uint32_t prefix = (base | (rd() & 0x3ffff)) & mask(length);
+                    table.insert(prefix, length, i);
+                    trie.insert(prefix, length, i);
+                    installed.emplace_back(prefix, length);
+                } else {
+                    const size_t victim = rd() % installed.size();
+                    const auto [prefix, length] = installed[victim];
+                    installed[victim] = installed.back();
+                    installed.pop_back();
+                    if (table.erase(prefix, length) != trie.erase(prefix, length)) {
+                        throw runtime_error("erase returned the wrong result");
+                    }
+                }
+                if (table.size() != trie.size()) {
+                    throw runtime_error("table holds " + to_string(table.size()) + " prefixes, expected " +
+                                        to_string(trie.size()));
+                }
+                for (unsigned j = 0; j < 16; j++) {
+                    check(table, trie, base | (rd() & 0x7ffff));
+                }
+                check(table, trie, rd());
+            }
+
+            // remove everything that is left; the table should end up empty again
+            for (const auto &[prefix, length] : installed) {
+                table.erase(prefix, length);
+            }
+            if (table.size() != 0 or table.lookup(base) != nullptr) {
+                throw runtime_error("table not empty after erasing every prefix");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+#include "eventloop.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+static pair<LocalStreamSocket, LocalStreamSocket> socket_pair() {
+    array<int, 2> fds{};
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+    return {LocalStreamSocket{FileDescriptor{fds[0]}}, LocalStreamSocket{FileDescriptor{fds[1]}}};
+}
+
+static void test_backend(const EventLoop::Backend backend) {
+    auto rd = get_random_generator();
+
+    // only the ready fds' callbacks run, and a rule is canceled at EOF
+    {
+        EventLoop loop{backend};
+        vector<pair<LocalStreamSocket, LocalStreamSocket>> pairs;
+        vector<string> received(200);
+        vector<bool> canceled(received.size());
+        for (size_t i = 0; i < received.size(); i++) {
+            pairs.push_back(socket_pair());
+            auto &reader = pairs.back().second;
+            loop.add_rule(
+                reader,
+                Direction::In,
+                [&, i] { received[i] += pairs[i].second.read(); },
+                [] { return true; },
+                [&, i] { canceled[i] = true; });
+        }
+
+        for (unsigned round = 0; round < 20; round++) {
+            vector<string> expected = received;
+            for (unsigned j = 0; j < 5; j++) {
+                const size_t i = rd() % pairs.size();
+                const string data = to_string(round) + "/" + to_string(j);
+                pairs[i].first.write(data);
+                expected[i] += data;
+            }
+            while (received != expected) {
+                test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "missed a readable fd");
+            }
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "spurious event");
+
+        for (auto &[writer, reader] : pairs) {
+            writer.close();
+        }
+        for (size_t i = 0; i < pairs.size(); i++) {
+            loop.wait_next_event(0);
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "rules not canceled at EOF");
+        test_err_if(find(canceled.begin(), canceled.end(), false) != canceled.end(), "cancel callback not called");
+    }
+
+    // a rule is only polled while it is interested, including when two rules share an fd
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool want_read = false, want_write = false;
+        unsigned reads = 0, writes = 0;
+        loop.add_rule(
+            b,
+            Direction::In,
+            [&] {
+                reads++;
+                b.read();
+            },
+            [&] { return want_read; });
+        loop.add_rule(
+            b,
+            Direction::Out,
+            [&] {
+                writes++;
+                b.write("x");
+                want_write = false;
+            },
+            [&] { return want_write; });
+
+        a.write("hello");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "uninterested rules were polled");
+
+        want_read = true;
+        test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success or reads != 1 or writes != 0,
+                    "interested reader not called");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "reader called with nothing to read");
+
+        want_write = true;
+        test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success or reads != 1 or writes != 1,
+                    "interested writer not called");
+        test_err_if(a.read() != "x", "writer's data not received");
+
+        want_read = false;
+        a.write("ignored for now");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "reader polled after losing interest");
+        want_read = true;
+        test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success or reads != 2,
+                    "reader not called after regaining interest");
+
+        // a hangup doesn't wake the loop while no rule on the fd is interested (epoll reports it regardless)
+        auto [c, d] = socket_pair();
+        loop.add_rule(d, Direction::In, [&] { d.read(); });
+        want_read = false;
+        a.shutdown(SHUT_RDWR);
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "hangup of an uninterested fd");
+    }
+
+    // regular files are always ready (epoll can't watch them, so they must be handled separately)
+    {
+        EventLoop loop{backend};
+        FileDescriptor file{SystemCall("open", ::open(".", O_TMPFILE | O_RDWR, 0600))};
+        file.write("contents of a regular file");
+        SystemCall("lseek", ::lseek(file.fd_num(), 0, SEEK_SET));
+        string contents;
+        bool canceled = false;
+        loop.add_rule(
+            file,
+            Direction::In,
+            [&] { contents += file.read(4); },
+            [] { return true; },
+            [&] { canceled = true; });
+        while (loop.wait_next_event(-1) != EventLoop::Result::Exit) {
+        }
+        test_err_if(contents != "contents of a regular file" or not canceled, "regular file not read to EOF");
+    }
+}
+
+static void test_timers(const EventLoop::Backend backend) {
+    EventLoop loop{backend};
+    test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "empty loop did not exit");
+
+    // one-shot and periodic timers fire on time, and keep the loop from exiting while pending
+    const uint64_t start = timestamp_ms();
+    vector<uint64_t> one_shot, periodic;
+    loop.add_timer(30, [&] { one_shot.push_back(timestamp_ms() - start); });
+    const auto periodic_id = loop.add_timer(10, [&] { periodic.push_back(timestamp_ms() - start); }, 10);
+    bool canceled_fired = false;
+    const auto canceled_id = loop.add_timer(20, [&] { canceled_fired = true; });
+    test_err_if(not loop.cancel_timer(canceled_id) or loop.cancel_timer(canceled_id), "cancel_timer result");
+
+    while (periodic.size() < 5) {
+        test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Success, "timer did not fire");
+    }
+    test_err_if(not loop.cancel_timer(periodic_id), "periodic timer not pending");
+    test_err_if(one_shot.size() != 1 or one_shot[0] < 30, "one-shot timer fired early or not at all");
+    for (size_t i = 0; i < periodic.size(); i++) {
+        test_err_if(periodic[i] < 10 * (i + 1), "periodic timer fired early");
+    }
+    test_err_if(periodic.back() >= 1000, "periodic timer fired late");
+    test_err_if(canceled_fired, "canceled timer fired");
+    test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Exit, "loop did not exit after timers finished");
+
+    // a timer shortens a wait for an fd, and a timeout shorter than the timer is respected
+    auto [a, b] = socket_pair();
+    loop.add_rule(b, Direction::In, [&] { b.read(); });
+    bool fired = false;
+    loop.add_timer(50, [&] { fired = true; });
+    test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout or fired, "timer fired early");
+    test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Success or not fired, "timer did not end the wait");
+    test_err_if(timestamp_ms() - start >= 5000, "wait took too long");
+}
+
+//! Run `test` on `backend`, naming the backend in any failure
+static void run(void (*test)(const EventLoop::Backend), const EventLoop::Backend backend) {
+    try {
+        test(backend);
+    } catch (const exception &e) {
+        throw runtime_error(string(backend == EventLoop::Backend::Epoll ? "epoll" : "poll") + ": " + e.what());
+    }
+}
+
+int main() {
+    try {
+        run(test_backend, EventLoop::Backend::Poll);
+        run(test_backend, EventLoop::Backend::Epoll);
+        run(test_timers, EventLoop::Backend::Poll);
+        run(test_timers, EventLoop::Backend::Epoll);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
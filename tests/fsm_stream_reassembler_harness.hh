@@ -103,6 +103,26 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct MemoryUsageAtMost : public ReassemblerExpectation {
+    size_t _bytes;
+
+    MemoryUsageAtMost(size_t bytes) : _bytes(bytes) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "reassembly memory usage <= " << _bytes;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.memory_usage() > _bytes) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to use at most `" << _bytes << "` bytes of memory, but it used `"
+               << reassembler.memory_usage() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -0,0 +1,121 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ReassemblerTestHarness test{1000000};
+
+            test.execute(MemoryUsageAtMost{0});
+
+            test.execute(SubmitSegment{"abcd", 0});
+
+            test.execute(BytesAssembled(4));
+            test.execute(MemoryUsageAtMost{0});
+        }
+
+        {
+            ReassemblerTestHarness test{1000000};
+
+            test.execute(SubmitSegment{string(100, 'x'), 500000});
+
+            test.execute(UnassembledBytes(100));
+            test.execute(MemoryUsageAtMost{1000});
+
+            test.execute(SubmitSegment{string(500000, 'y'), 0});
+
+            test.execute(BytesAssembled(500100));
+            test.execute(UnassembledBytes(0));
+            test.execute(MemoryUsageAtMost{0});
+        }
+
+        {
+            ReassemblerTestHarness test{1000000};
+
+            for (size_t i = 1; i < 100; i += 2) {
+                test.execute(SubmitSegment{string(10, 'b'), i * 10});
+            }
+
+            test.execute(UnassembledBytes(500));
+
+            for (size_t i = 0; i < 100; i += 2) {
+                test.execute(SubmitSegment{string(10, 'a'), i * 10});
+            }
+
+            test.execute(BytesAssembled(1000));
+            test.execute(MemoryUsageAtMost{0});
+        }
+
+        {
+            StreamReassembler reassembler{1000, ByteStream::Storage::Chunked};
+            const Buffer first{string("abcd")};
+            const Buffer second{string("efgh")};
+
+            reassembler.push_substring(second, 4, true);
+            reassembler.push_substring(first, 0, false);
+
+            // both payloads reach the output stream as slices of the pushed Buffers
+            const auto iovecs = reassembler.stream_out().peek_output_views(8).as_iovecs();
+            if (iovecs.size() != 2 or iovecs[0].iov_base != first.str().data() or
+                iovecs[1].iov_base != second.str().data()) {
+                throw runtime_error("pushed Buffers were copied into the output stream");
+            }
+            if (reassembler.stream_out().read(8) != "abcdefgh" or not reassembler.stream_out().eof()) {
+                throw runtime_error("zero-copy reassembly produced the wrong stream");
+            }
+        }
+
+        {
+            // small slices of a big Buffer are copied rather than pinning it, and the big ones are counted in full
+            StreamReassembler reassembler{100000, ByteStream::Storage::Chunked};
+            for (size_t i = 1; i < 100; i += 2) {
+                Buffer datagram{string(65536, 'x')};
+                datagram.remove_suffix(65535);
+                reassembler.push_substring(datagram, i, false);
+            }
+            if (reassembler.memory_usage() > 50 * 1000) {
+                throw runtime_error("1-byte slices pinned their Buffers in the reassembler");
+            }
+            for (size_t i = 0; i < 100; i += 2) {
+                Buffer datagram{string(65536, 'x')};
+                datagram.remove_suffix(65535);
+                reassembler.push_substring(datagram, i, false);
+            }
+            if (reassembler.stream_out().memory_usage() > 100 * 1000) {
+                throw runtime_error("1-byte slices pinned their Buffers in the output stream");
+            }
+
+            Buffer half{string(4000, 'y')};
+            half.remove_prefix(1900);
+            reassembler.push_substring(half, 200, false);
+            if (reassembler.memory_usage() < 4000) {
+                throw runtime_error("memory_usage() does not count a slice's whole storage");
+            }
+        }
+
+        // the string overload copies only the bytes inside the window
+        {
+            StreamReassembler reassembler{10};
+            reassembler.push_substring(string(1000000, 'z'), 5, true);
+            if (reassembler.unassembled_bytes() != 5 or reassembler.memory_usage() > 1000) {
+                throw runtime_error("bytes outside the window were stored");
+            }
+            reassembler.push_substring(string(5, 'z'), 0, false);
+            if (reassembler.stream_out().buffer_size() != 10 or reassembler.stream_out().input_ended()) {
+                throw runtime_error("wrong stream after a trimmed push");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
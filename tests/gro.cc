@@ -0,0 +1,112 @@
+#include "tcp_connection.hh"
+#include "test_err_if.hh"
+#include "test_utils_tcp_connection.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPSegment data_segment(const uint32_t seqno, const size_t size, const char fill = 'x') {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32{7};
+    seg.header().win = 1234;
+    seg.payload() = string(size, fill);
+    return seg;
+}
+
+int main() {
+    try {
+        // coalesce() undoes split(): one segment with the whole payload, FIN and PSH
+        {
+            TCPSegment super = data_segment(100, 2 * MSS, 'a');
+            super.payload() = string(2 * MSS, 'a') + string(MSS / 2, 'b');
+            super.header().fin = true;
+            super.header().psh = true;
+            super.gso_size() = MSS;
+            const auto merged = TCPSegment::coalesce(super.split(), TCPConfig::MAX_GSO_SIZE);
+            test_err_if(merged.size() != 1, "pieces not merged");
+            const TCPHeader &h = merged[0].header();
+            test_err_if(h.seqno != WrappingInt32{100} or not h.fin or not h.psh or h.ackno != WrappingInt32{7} or
+                            h.win != 1234,
+                        "wrong merged header");
+            test_err_if(merged[0].payload().str() != super.payload().str(), "wrong merged payload");
+        }
+
+        // a run ends at a gap, a new ACK, a window update, a FIN, an empty segment or a RST, and at max_payload
+        {
+            vector<TCPSegment> segs;
+            segs.push_back(data_segment(1, 100));
+            segs.push_back(data_segment(101, 100));
+            segs.push_back(data_segment(301, 100));  // gap
+            segs.push_back(data_segment(401, 100));
+            segs.push_back(data_segment(501, 100));
+            segs.back().header().ackno = WrappingInt32{8};
+            segs.push_back(data_segment(601, 100));
+            segs.back().header().ackno = WrappingInt32{8};
+            segs.back().header().win = 1;
+            segs.push_back(data_segment(701, 100));
+            segs.back().header().ackno = WrappingInt32{8};
+            segs.back().header().win = 1;
+            segs.back().header().fin = true;
+            segs.push_back(data_segment(802, 100));
+            segs.push_back(data_segment(902, 0));
+            segs.push_back(data_segment(902, 100));
+            segs.back().header().rst = true;
+            const auto merged = TCPSegment::coalesce(move(segs), TCPConfig::MAX_GSO_SIZE);
+            const vector<size_t> sizes{200, 200, 100, 200, 100, 0, 100};
+            test_err_if(merged.size() != sizes.size(), "wrong number of runs");
+            for (size_t i = 0; i < sizes.size(); i++) {
+                test_err_if(merged[i].payload().size() != sizes[i], "wrong run " + to_string(i));
+            }
+            test_err_if(merged[1].header().seqno != WrappingInt32{301} or not merged[3].header().fin or
+                            merged[3].header().win != 1,
+                        "wrong run headers");
+
+            vector<TCPSegment> many;
+            for (uint32_t i = 0; i < 5; i++) {
+                many.push_back(data_segment(1 + i * 100, 100));
+            }
+            test_err_if(TCPSegment::coalesce(move(many), 250).size() != 3, "max_payload exceeded");
+        }
+
+        // the receiving connection makes one ACK decision for a whole burst
+        {
+            for (const bool gro : {false, true}) {
+                TCPConnection a{TCPConfig{}}, b{TCPConfig{}};
+                a.connect();
+                for (const bool to_b : {true, false, true}) {
+                    for (auto &seg : take(to_b ? a : b)) {
+                        (to_b ? b : a).segment_received(seg);
+                    }
+                }
+
+                a.write(string(10 * MSS, 'x'));
+                auto burst = take(a);
+                test_err_if(burst.size() != 10, "burst not sent");
+                if (gro) {
+                    burst = TCPSegment::coalesce(move(burst), TCPConfig::MAX_GSO_SIZE);
+                }
+                for (const auto &seg : burst) {
+                    b.segment_received(seg);
+                }
+                const auto acks = take(b);
+                test_err_if(acks.size() != (gro ? 1 : 10), "wrong number of ACKs");
+                a.segment_received(acks.back());
+                test_err_if(a.bytes_in_flight() != 0 or b.inbound_stream().buffer_size() != 10 * MSS,
+                            "burst not received");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "fd_adapter.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPSegment super_segment(const bool syn) {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{100};
+    seg.header().syn = syn;
+    seg.header().fin = true;
+    seg.header().psh = true;
+    seg.header().win = 1234;
+    seg.payload() = string(2 * MSS, 'a') + string(MSS / 2, 'b');
+    seg.gso_size() = MSS;
+    return seg;
+}
+
+int main() {
+    try {
+        // split() copies the header into each piece and slices the payload
+        {
+            const auto pieces = super_segment(false).split();
+            test_err_if(pieces.size() != 3, "wrong number of pieces");
+            for (size_t i = 0; i < 3; i++) {
+                const TCPHeader &h = pieces[i].header();
+                test_err_if(h.seqno != WrappingInt32{static_cast<uint32_t>(100 + i * MSS)} or h.win != 1234,
+                            "piece header not derived from the super-segment's");
+                test_err_if(h.fin != (i == 2) or h.psh != (i == 2) or pieces[i].gso_size() != 0, "wrong piece flags");
+            }
+            test_err_if(pieces[1].payload().str() != string(MSS, 'a') or
+                            pieces[2].payload().str() != string(MSS / 2, 'b'),
+                        "wrong piece payloads");
+
+            const auto with_syn = super_segment(true).split();
+            test_err_if(not with_syn[0].header().syn or with_syn[1].header().syn or
+                            with_syn[1].header().seqno != WrappingInt32{101 + MSS},
+                        "SYN not kept on the first piece only");
+
+            TCPSegment small = super_segment(false);
+            small.payload() = string(MSS, 'a');
+            const auto whole = small.split();
+            test_err_if(whole.size() != 1 or whole[0].gso_size() != 0 or not whole[0].header().fin,
+                        "small segment was cut");
+        }
+
+        // with gso the sender queues one super-segment, but keeps and retransmits MSS-sized pieces
+        {
+            TCPConfig cfg;
+            cfg.gso = true;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.segments_out() = {};
+            sender.stream_in().write(string(20 * MSS + 10, 'x'));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 1, "sender did not queue a single super-segment");
+            const TCPSegment &seg = sender.segments_out().front();
+            test_err_if(seg.gso_size() != MSS or seg.payload().size() != 20 * MSS + 10, "wrong super-segment");
+            sender.segments_out() = {};
+
+            sender.ack_received(WrappingInt32{1 + 3 * MSS}, 60000);
+            test_err_if(sender.bytes_in_flight() != 17 * MSS + 10, "pieces not acknowledged one at a time");
+            sender.tick(cfg.rt_timeout);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != MSS or
+                            sender.segments_out().front().header().seqno != WrappingInt32{1 + 3 * MSS},
+                        "timeout did not retransmit just the first outstanding piece");
+        }
+
+        // the UDP adapter sends one datagram per piece
+        {
+            UDPSocket receiver;
+            receiver.bind(Address{"127.0.0.1", 0});
+            UDPSocket sock;
+            sock.bind(Address{"127.0.0.1", 0});
+            TCPOverUDPSocketAdapter adapter{move(sock)};
+            adapter.config_mut().destination = receiver.local_address();
+            TCPSegment seg = super_segment(false);
+            adapter.write(seg);
+            for (size_t i = 0; i < 3; i++) {
+                TCPSegment piece;
+                test_err_if(piece.parse(receiver.recv().payload) != ParseResult::NoError, "piece did not parse");
+                test_err_if(piece.payload().size() != (i < 2 ? MSS : MSS / 2) or piece.header().fin != (i == 2),
+                            "wrong datagram");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
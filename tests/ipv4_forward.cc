@@ -0,0 +1,72 @@
+#include "ipv4_datagram.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static string serialized(const IPv4Datagram &dgram) { return dgram.serialize().concatenate(); }
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // incremental adjustment agrees with recomputing the checksum from scratch
+        for (unsigned i = 0; i < 10000; i++) {
+            string data(20, 0);
+            for (auto &ch : data) {
+                ch = rd();
+            }
+            InternetChecksum before;
+            before.add(data);
+
+            const size_t word = 2 * (rd() % 10);
+            const uint16_t old_word = (uint8_t(data[word]) << 8) | uint8_t(data[word + 1]);
+            const uint16_t new_word = rd();
+            data[word] = static_cast<char>(new_word >> 8);
+            data[word + 1] = static_cast<char>(new_word & 0xff);
+            InternetChecksum after;
+            after.add(data);
+
+            if (InternetChecksum::adjust(before.value(), old_word, new_word) != after.value()) {
+                throw runtime_error("InternetChecksum::adjust disagrees with a full recomputation");
+            }
+        }
+
+        // forwarding fast path produces the same bytes as re-serializing the header
+        for (unsigned i = 0; i < 1000; i++) {
+            IPv4Datagram original;
+            original.header().ttl = 2 + rd() % 254;
+            original.header().id = rd();
+            original.header().src = rd();
+            original.header().dst = rd();
+            original.payload() = string(rd() % 100, 'x');
+            original.header().len = IPv4Header::LENGTH + original.payload().size();
+
+            IPv4Datagram forwarded;
+            if (forwarded.parse(serialized(original)) != ParseResult::NoError) {
+                throw runtime_error("failed to parse original datagram");
+            }
+            forwarded.decrement_ttl();
+
+            original.header().ttl--;
+            const string expected = serialized(original);
+            const string actual = serialized(forwarded);
+            if (actual != expected) {
+                throw runtime_error("decrement_ttl produced a different datagram than a full re-serialization");
+            }
+
+            IPv4Datagram reparsed;
+            if (reparsed.parse(string(actual)) != ParseResult::NoError or
+                reparsed.header().ttl != original.header().ttl) {
+                throw runtime_error("forwarded datagram does not parse correctly");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
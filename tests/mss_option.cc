@@ -0,0 +1,95 @@
+#include "congestion_control.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "test_err_if.hh"
+#include "test_utils_tcp_connection.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static TCPConfig config(const uint16_t mss) {
+    TCPConfig cfg;
+    cfg.mss = mss;
+    cfg.congestion_control = TCPConfig::Congestion::NewReno;
+    return cfg;
+}
+
+//! Largest payload among `segs`
+static size_t largest(const vector<TCPSegment> &segs) {
+    size_t size = 0;
+    for (const auto &seg : segs) {
+        size = max(size, seg.payload().size());
+    }
+    return size;
+}
+
+int main() {
+    try {
+        // the option survives serialization
+        {
+            TCPHeader h;
+            h.syn = true;
+            h.mss = 8960;
+            h.wscale = 3;
+            h.doff = (TCPHeader::LENGTH + h.options_length()) / 4;
+            TCPHeader parsed;
+            NetParser p{string{h.serialize()}};
+            test_err_if(not (parsed.parse(p) == ParseResult::NoError and parsed == h), "MSS option did not round-trip");
+        }
+
+        // each side offers its own MSS, and both send segments no larger than the smaller one
+        {
+            TCPConnection a{config(1460)}, b{config(8960)};
+            a.connect();
+            test_err_if(deliver(a, b).front().header().mss != 1460, "SYN did not offer the MSS");
+            test_err_if(deliver(b, a).front().header().mss != 8960, "SYN-ACK did not offer the MSS");
+            deliver(a, b);
+
+            a.write(string(20000, 'x'));
+            b.write(string(20000, 'x'));
+            test_err_if(largest(deliver(a, b)) != 1460, "sender did not use its own MSS");
+            test_err_if(largest(deliver(b, a)) != 1460, "sender exceeded the peer's MSS");
+            deliver(a, b);
+        }
+
+        // the congestion window counts in the agreed MSS (plus the byte of the SYN, whose ACK grew it)
+        {
+            TCPConnection a{config(1460)}, b{config(8960)};
+            a.connect();
+            deliver(a, b);
+            deliver(b, a);
+            deliver(a, b);
+            b.write(string(64000, 'x'));
+            deliver(b, a);
+            test_err_if(b.bytes_in_flight() != 10 * 1460 + 1, "initial window not 10 segments of the agreed MSS");
+        }
+
+        // a peer that sends no MSS option is sent segments of TCPConfig::mss
+        {
+            TCPConnection a{config(4000)};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = WrappingInt32{0};
+            syn.header().win = 60000;
+            a.segment_received(syn);
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().seqno = WrappingInt32{1};
+            ack.header().ackno = a.segments_out().front().header().seqno + 1;
+            ack.header().win = 60000;
+            a.segments_out().pop();
+            a.segment_received(ack);
+            a.write(string(10000, 'x'));
+            test_err_if(a.segments_out().front().payload().size() != 4000, "MSS changed without an option");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "congestion_control.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Number of segments `sender` has queued, which it forgets
+static size_t sent(TCPSender &sender) {
+    const size_t n = sender.segments_out().size();
+    sender.segments_out() = {};
+    return n;
+}
+
+//! A sender whose SYN has been acknowledged after `rtt` ms
+static TCPSender connected_sender(const TCPConfig &cfg, const size_t rtt) {
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.tick(rtt);
+    sender.ack_received(WrappingInt32{1}, 60000);
+    sent(sender);
+    return sender;
+}
+
+static TCPConfig config(const bool pacing, const size_t rate, const TCPConfig::Congestion congestion) {
+    TCPConfig cfg;
+    cfg.pacing = pacing;
+    cfg.pacing_rate = rate;
+    cfg.congestion_control = congestion;
+    cfg.fixed_isn = WrappingInt32{0};
+    return cfg;
+}
+
+int main() {
+    try {
+        // without pacing the whole window goes out at once
+        {
+            TCPSender sender = connected_sender(config(false, 0, TCPConfig::Congestion::None), 10);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sent(sender) != 20 or sender.pacing_rate() != 0, "unpaced sender held segments back");
+        }
+
+        // at a configured 2 segments per ms, 20 segments take 10 ms
+        {
+            TCPSender sender = connected_sender(config(true, 2 * MSS, TCPConfig::Congestion::None), 10);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            size_t total = sent(sender);
+            test_err_if(total != 2 or sender.time_until_paced_send() != 1, "first burst not limited to the credit");
+            for (size_t ms = 1; ms <= 9; ms++) {
+                sender.tick(1);
+                const size_t n = sent(sender);
+                test_err_if(n != 2, "paced sender sent " + to_string(n) + " segments in a millisecond");
+                total += n;
+            }
+            test_err_if(total != 20 or sender.time_until_paced_send().has_value(), "paced transfer incomplete");
+            test_err_if(sender.bytes_in_flight() != 20 * MSS, "pacing lost data");
+        }
+
+        // an estimated rate of 2 * cwnd / SRTT in slow start sends the window over half an RTT
+        {
+            TCPSender sender = connected_sender(config(true, 0, TCPConfig::Congestion::NewReno), 10);
+            const CongestionControl &cc = *sender.congestion_control();
+            test_err_if(sender.srtt() != 10.0, "pacing did not measure the RTT");
+            test_err_if(sender.pacing_rate() != 2.0 * cc.cwnd() / 10, "wrong estimated rate in slow start");
+            sender.stream_in().write(string(50 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() >= cc.cwnd(), "estimated pacing sent the window in one burst");
+            for (size_t ms = 1; ms <= 5; ms++) {
+                sender.tick(1);
+            }
+            test_err_if(sender.bytes_in_flight() != cc.cwnd(), "window not sent within half an RTT");
+        }
+
+        // a TCPConnection wakes up for the pacing timer
+        {
+            TCPConfig cfg = config(true, MSS, TCPConfig::Congestion::None);
+            TCPConnection a{cfg}, b{cfg};
+            a.connect();
+            b.segment_received(a.segments_out().front());
+            a.segments_out().pop();
+            a.segment_received(b.segments_out().front());
+            b.segments_out().pop();
+            a.segments_out() = {};
+            a.write(string(5 * MSS, 'x'));
+            const size_t first = a.segments_out().size();
+            test_err_if(first >= 5 or a.time_until_next_timeout() != 1, "connection did not schedule the paced send");
+            a.tick(1);
+            test_err_if(a.segments_out().size() != first + 1, "pacing timer did not send the next segment");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
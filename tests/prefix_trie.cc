@@ -0,0 +1,96 @@
+#include "prefix_trie.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+//! Routes keyed by (length, prefix), so that longer prefixes sort later
+using RouteMap = map<pair<uint8_t, uint32_t>, int>;
+
+static uint32_t mask(const uint8_t length) { return length == 0 ? 0 : ~uint32_t(0) << (32 - length); }
+
+//! The longest-prefix match in `routes`, or -1
+static int reference_lookup(const RouteMap &routes, const uint32_t address) {
+    for (auto it = routes.rbegin(); it != routes.rend(); ++it) {
+        if (((address ^ it->first.second) & mask(it->first.first)) == 0) {
+            return it->second;
+        }
+    }
+    return -1;
+}
+
+static void check(const PrefixTrie<int> &trie, const RouteMap &routes, const uint32_t address) {
+    const int *actual = trie.lookup(address);
+    const int expected = reference_lookup(routes, address);
+    if ((actual ? *actual : -1) != expected) {
+        throw runtime_error("lookup of " + to_string(address) + " returned " + to_string(actual ? *actual : -1) +
+                            ", expected " + to_string(expected));
+    }
+    if (trie.size() != routes.size()) {
+        throw runtime_error("trie holds " + to_string(trie.size()) + " prefixes, expected " +
+                            to_string(routes.size()));
+    }
+}
+
+int main() {
+    try {
+        {
+            PrefixTrie<int> trie;
+            if (trie.lookup(0x01020304)) {
+                throw runtime_error("empty trie matched an address");
+            }
+            trie.insert(0x0a000000, 8, 1);
+            trie.insert(0x0a010000, 16, 2);
+            trie.insert(0x0a010203, 32, 3);
+            trie.insert(0xffffffff, 0, 4);  // default route; the address bits are ignored
+            if (*trie.lookup(0x0a010203) != 3 or *trie.lookup(0x0a010204) != 2 or *trie.lookup(0x0a020000) != 1 or
+                *trie.lookup(0x0b000000) != 4) {
+                throw runtime_error("wrong longest-prefix match");
+            }
+            trie.insert(0x0a01ffff, 16, 5);  // replaces the /16
+            if (trie.size() != 4 or *trie.lookup(0x0a010204) != 5) {
+                throw runtime_error("insert did not replace the existing route");
+            }
+            if (trie.erase(0x0a000000, 9) or trie.erase(0x0a010200, 24) or not trie.erase(0x0a010000, 16) or
+                trie.erase(0x0a010000, 16)) {
+                throw runtime_error("erase of a missing route");
+            }
+            if (*trie.lookup(0x0a010204) != 1 or *trie.lookup(0x0a010203) != 3) {
+                throw runtime_error("wrong match after erase");
+            }
+        }
+
+        // random prefixes clustered in a small part of the address space, so they nest and share paths
+        auto rd = get_random_generator();
+        for (unsigned round = 0; round < 100; round++) {
+            PrefixTrie<int> trie;
+            RouteMap routes;
+            for (int i = 0; i < 200; i++) {
+                const uint8_t length = rd() % 33;
+                const uint32_t prefix = (0xc0a80000 | (rd() & 0x3ff)) & mask(length);
+                if (rd() % 4 == 0) {
+                    const bool erased = trie.erase(prefix, length);
+                    if (erased != (routes.erase({length, prefix}) == 1)) {
+                        throw runtime_error("erase returned the wrong result");
+                    }
+                } else {
+                    trie.insert(prefix, length, i);
+                    routes[{length, prefix}] = i;
+                }
+                for (unsigned j = 0; j < 8; j++) {
+                    check(trie, routes, 0xc0a80000 | (rd() & 0x7ff));
+                }
+                check(trie, routes, rd());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Send `bytes` (or the SYN, if nothing has been sent yet), wait `rtt` ms and acknowledge everything
+static void round_trip(TCPSender &sender, const size_t bytes, const size_t rtt) {
+    sender.stream_in().write(string(bytes, 'x'));
+    sender.fill_window();
+    sender.segments_out() = {};
+    sender.tick(rtt);
+    sender.ack_received(sender.next_seqno(), 60000);
+}
+
+static TCPSender adaptive_sender(const unsigned rto_min, const unsigned rto_max = TCPConfig::RTO_MAX_DFLT) {
+    TCPConfig cfg;
+    cfg.adaptive_rto = true;
+    cfg.rto_min = rto_min;
+    cfg.rto_max = rto_max;
+    cfg.fixed_isn = WrappingInt32{0};
+    return TCPSender{cfg};
+}
+
+int main() {
+    try {
+        // without adaptive_rto the RTO stays at rt_timeout
+        {
+            TCPConfig cfg;
+            TCPSender sender{cfg};
+            round_trip(sender, 0, 10);
+            round_trip(sender, 100, 10);
+            test_err_if(sender.srtt().has_value() or sender.rto() != cfg.rt_timeout, "fixed RTO changed");
+        }
+
+        // SRTT and RTTVAR follow RFC 6298, and RTO = SRTT + 4 * RTTVAR
+        {
+            TCPSender sender = adaptive_sender(1);
+            test_err_if(sender.rto() != TCPConfig::TIMEOUT_DFLT, "initial RTO is not rt_timeout");
+            round_trip(sender, 0, 10);
+            test_err_if(sender.srtt() != 10.0 or sender.rto() != 30, "first sample did not set SRTT = R, RTTVAR = R/2");
+            round_trip(sender, 100, 10);
+            test_err_if(sender.srtt() != 10.0 or sender.rto() != 25, "second sample did not shrink RTTVAR");
+            round_trip(sender, 100, 20);
+            test_err_if(sender.srtt() != 11.25 or sender.rto() != 33, "third sample did not move SRTT by 1/8");
+
+            // Karn: the ACK of a retransmitted segment is not a sample, and backoff doubles the RTO
+            const unsigned rto = sender.rto();
+            sender.stream_in().write("x");
+            sender.fill_window();
+            sender.tick(rto);
+            test_err_if(sender.segments_out().size() != 2 or sender.rto() != 2 * rto, "timeout did not back off");
+            sender.tick(1);
+            sender.ack_received(sender.next_seqno(), 60000);
+            test_err_if(sender.srtt() != 11.25 or sender.rto() != rto, "retransmitted segment was sampled");
+        }
+
+        // sub-millisecond RTTs bring the RTO down to the clock's granularity
+        {
+            TCPSender sender = adaptive_sender(1);
+            for (size_t i = 0; i < 3; i++) {
+                round_trip(sender, i == 0 ? 0 : 100, 0);
+            }
+            test_err_if(sender.srtt() != 0.0 or sender.rto() != 1, "RTO did not converge to 1 ms");
+        }
+
+        // the RTO and its backoff stay within [rto_min, rto_max]
+        {
+            TCPSender sender = adaptive_sender(200, 300);
+            round_trip(sender, 0, 10);
+            test_err_if(sender.rto() != 200, "RTO fell below rto_min");
+            sender.stream_in().write("x");
+            sender.fill_window();
+            for (size_t i = 0; i < 3; i++) {
+                sender.tick(sender.rto());
+            }
+            test_err_if(sender.consecutive_retransmissions() != 3 or sender.rto() != 300, "backoff exceeded rto_max");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "test_err_if.hh"
+#include "test_utils_tcp_connection.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const size_t size) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.payload() = string(size, 'x');
+    return seg;
+}
+
+//! Lose segments 2, 5 and 8 of a 20-segment flight, and check that all three are resent before any timeout
+static void multi_loss(const TCPConfig::Congestion congestion) {
+    TCPConfig cfg;
+    cfg.congestion_control = congestion;
+    cfg.send_capacity = 20 * MSS;
+    TCPConnection a{cfg}, b{cfg};
+    a.connect();
+    deliver(a, b);
+    deliver(b, a);
+    deliver(a, b);
+
+    // with a congestion controller, first grow cwnd past 20 segments
+    if (congestion != TCPConfig::Congestion::None) {
+        a.write(string(20 * MSS, 'x'));
+        while (a.bytes_in_flight() > 0) {
+            deliver(a, b);
+            deliver(b, a);
+        }
+        b.inbound_stream().pop_output(b.inbound_stream().buffer_size());
+    }
+
+    a.write(string(20 * MSS, 'x'));
+    const size_t in_flight = a.bytes_in_flight();
+    test_err_if(in_flight != 20 * MSS, "window not filled");
+    const auto sent = deliver(a, b, {2, 5, 8});
+    const auto acks = deliver(b, a);
+    test_err_if(acks.back().header().sack.size() != 3, "receiver did not report three SACK blocks");
+
+    const auto resent = take(a);
+    test_err_if(resent.size() < 3, "holes were not all retransmitted at once");
+    for (size_t i = 0; i < 3; i++) {
+        test_err_if(resent[i].header().seqno != sent[2 + 3 * i].header().seqno,
+                    "retransmitted something other than a hole");
+    }
+    for (const auto &seg : resent) {
+        b.segment_received(seg);
+    }
+    deliver(b, a);
+    test_err_if(a.bytes_in_flight() != 0 or b.unassembled_bytes() != 0 or b.inbound_stream().buffer_size() != in_flight,
+                "transfer not complete within one RTT of the loss");
+}
+
+int main() {
+    try {
+        // SACK-permitted and SACK blocks survive serialization
+        {
+            TCPHeader h;
+            h.sack_permitted = true;
+            h.sack = {{WrappingInt32{1001}, WrappingInt32{2001}}, {WrappingInt32{3001}, WrappingInt32{4001}}};
+            h.doff = (TCPHeader::LENGTH + h.options_length()) / 4;
+            TCPHeader parsed;
+            NetParser p{string{h.serialize()}};
+            test_err_if(not (parsed.parse(p) == ParseResult::NoError and parsed == h),
+                        "SACK options did not round-trip");
+        }
+
+        // the receiver reports the block with the newest segment first, then the others in order
+        {
+            TCPReceiver receiver{64000};
+            TCPSegment syn;
+            syn.header().syn = true;
+            receiver.segment_received(syn);
+            receiver.segment_received(data_segment(WrappingInt32{3001}, 1000));
+            receiver.segment_received(data_segment(WrappingInt32{5001}, 1000));
+            receiver.segment_received(data_segment(WrappingInt32{1001}, 1000));
+            receiver.segment_received(data_segment(WrappingInt32{2001}, 1000));
+            const auto blocks = receiver.sack_blocks(TCPHeader::MAX_SACK_BLOCKS);
+            const TCPHeader::SackBlock newest{WrappingInt32{1001}, WrappingInt32{4001}};
+            const TCPHeader::SackBlock other{WrappingInt32{5001}, WrappingInt32{6001}};
+            test_err_if(not (blocks.size() == 2 and blocks[0] == newest and blocks[1] == other), "wrong SACK blocks");
+            test_err_if(not (receiver.sack_blocks(1).size() == 1 and receiver.sack_blocks(1)[0] == newest),
+                        "newest block not kept");
+            receiver.segment_received(data_segment(WrappingInt32{1}, 1000));
+            test_err_if(receiver.sack_blocks(TCPHeader::MAX_SACK_BLOCKS).size() != 1, "filled hole still reported");
+        }
+
+        multi_loss(TCPConfig::Congestion::None);
+        multi_loss(TCPConfig::Congestion::NewReno);
+
+        // without SACK, the same losses are left for the retransmission timer
+        {
+            TCPConfig cfg, no_sack;
+            no_sack.sack = false;
+            TCPConnection a{cfg}, b{no_sack};
+            a.connect();
+            test_err_if(not deliver(a, b).front().header().sack_permitted, "SYN did not offer SACK");
+            test_err_if(deliver(b, a).front().header().sack_permitted,
+                        "SYN-ACK accepted SACK it wasn't configured for");
+            deliver(a, b);
+            a.write(string(20 * MSS, 'x'));
+            deliver(a, b, {2, 5, 8});
+            const auto acks = deliver(b, a);
+            test_err_if(not acks.back().header().sack.empty() or not a.segments_out().empty(),
+                        "SACK used without agreement");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
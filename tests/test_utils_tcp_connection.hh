@@ -0,0 +1,32 @@
+#ifndef SPONGE_TESTS_TEST_UTILS_TCP_CONNECTION_HH
+#define SPONGE_TESTS_TEST_UTILS_TCP_CONNECTION_HH
+
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+//! Take every segment `conn` has queued
+inline std::vector<TCPSegment> take(TCPConnection &conn) {
+    std::vector<TCPSegment> segs;
+    while (not conn.segments_out().empty()) {
+        segs.push_back(conn.segments_out().front());
+        conn.segments_out().pop();
+    }
+    return segs;
+}
+
+//! Hand every segment `from` has queued to `to`, except the ones numbered in `drop`, returning them all
+inline std::vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to, const std::set<size_t> &drop = {}) {
+    const auto segs = take(from);
+    for (size_t i = 0; i < segs.size(); i++) {
+        if (not drop.count(i)) {
+            to.segment_received(segs[i]);
+        }
+    }
+    return segs;
+}
+
+#endif  // SPONGE_TESTS_TEST_UTILS_TCP_CONNECTION_HH
@@ -0,0 +1,26 @@
+#ifndef SPONGE_TESTS_TEST_UTILS_UDP_HH
+#define SPONGE_TESTS_TEST_UTILS_UDP_HH
+
+#include "socket.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <string>
+
+//! A UDP socket bound to an unused port on the loopback interface
+inline UDPSocket bound_socket() {
+    UDPSocket sock;
+    sock.bind(Address{"127.0.0.1", 0});
+    return sock;
+}
+
+//! A segment with `size` bytes of payload, all the same letter, which depends on `seqno`
+inline TCPSegment data_segment(const uint32_t seqno, const size_t size) {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.payload() = std::string(size, char('a' + seqno % 26));
+    return seg;
+}
+
+#endif  // SPONGE_TESTS_TEST_UTILS_UDP_HH
@@ -0,0 +1,129 @@
+#include "timing_wheel.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+//! An armed timer in the reference model
+struct Expected {
+    uint64_t deadline;
+    TimingWheel::TimerID id;
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // basics: expiry time, cancel, stale IDs, and re-arming from the callback
+        {
+            TimingWheel wheel;
+            vector<uint64_t> fired;
+            const auto record = [&](const uint64_t token) { fired.push_back(token); };
+            const auto a = wheel.arm(100, 1);
+            const auto b = wheel.arm(50, 2);
+            const auto c = wheel.arm(0, 3);
+            if (wheel.size() != 3 or wheel.time_left(a) != 100 or wheel.time_left(c) != 0) {
+                throw runtime_error("wrong state after arming");
+            }
+            wheel.advance(0, record);
+            if (fired != vector<uint64_t>{3} or wheel.time_left(c).has_value() or wheel.cancel(c)) {
+                throw runtime_error("timer with no delay did not expire on advance(0)");
+            }
+            wheel.advance(49, record);
+            if (fired.size() != 1 or wheel.time_left(b) != 1) {
+                throw runtime_error("timer expired early");
+            }
+            if (not wheel.cancel(b) or wheel.cancel(b) or wheel.size() != 1) {
+                throw runtime_error("cancel failed");
+            }
+            wheel.advance(1000, [&](const uint64_t token) {
+                fired.push_back(token);
+                wheel.arm(10, token + 10);
+            });
+            if (fired != vector<uint64_t>{3, 1} or wheel.now() != 1049 or wheel.size() != 1) {
+                throw runtime_error("wrong timers fired");
+            }
+            wheel.advance(9, record);
+            wheel.advance(1, record);
+            if (fired != vector<uint64_t>{3, 1, 11} or wheel.size() != 0) {
+                throw runtime_error("timer re-armed from a callback did not count from the new time");
+            }
+            // a new timer reusing a freed node must not answer to the old ID
+            const auto d = wheel.arm(5, 4);
+            if (wheel.cancel(a) or not wheel.time_left(d).has_value()) {
+                throw runtime_error("stale ID matched a new timer");
+            }
+        }
+
+        // random arm/cancel/advance against a reference, with deadlines out past every level of the wheel
+        for (unsigned round = 0; round < 20; round++) {
+            TimingWheel wheel;
+            multimap<uint64_t, uint64_t> by_deadline;  // deadline -> token
+            map<uint64_t, Expected> armed;             // token -> timer
+            uint64_t next_token = 0;
+            for (unsigned step = 0; step < 5000; step++) {
+                const unsigned action = rd() % 10;
+                if (action < 5) {
+                    static constexpr uint64_t scales[] = {64, 4096, 262144, 16777216, uint64_t(1) << 28};
+                    const uint64_t delay = rd() % scales[rd() % 5];
+                    const uint64_t token = next_token++;
+                    const auto id = wheel.arm(delay, token);
+                    armed[token] = {wheel.now() + delay, id};
+                    by_deadline.emplace(wheel.now() + delay, token);
+                } else if (action < 7 and not armed.empty()) {
+                    auto it = armed.lower_bound(rd() % next_token);
+                    if (it == armed.end()) {
+                        it = armed.begin();
+                    }
+                    if (not wheel.cancel(it->second.id)) {
+                        throw runtime_error("armed timer could not be canceled");
+                    }
+                    for (auto range = by_deadline.equal_range(it->second.deadline); range.first != range.second;
+                         ++range.first) {
+                        if (range.first->second == it->first) {
+                            by_deadline.erase(range.first);
+                            break;
+                        }
+                    }
+                    armed.erase(it);
+                } else {
+                    static constexpr uint64_t scales[] = {2, 100, 10000, 1000000, 100000000};
+                    const uint64_t ms = rd() % scales[rd() % 5];
+                    wheel.advance(ms, [&](const uint64_t token) {
+                        const auto it = armed.find(token);
+                        if (it == armed.end() or it->second.deadline > wheel.now()) {
+                            throw runtime_error("timer " + to_string(token) + " expired at the wrong time");
+                        }
+                        armed.erase(it);
+                    });
+                    while (not by_deadline.empty() and by_deadline.begin()->first <= wheel.now()) {
+                        if (armed.count(by_deadline.begin()->second)) {
+                            throw runtime_error("timer " + to_string(by_deadline.begin()->second) +
+                                                " did not expire");
+                        }
+                        by_deadline.erase(by_deadline.begin());
+                    }
+                }
+
+                if (wheel.size() != armed.size()) {
+                    throw runtime_error("wheel holds " + to_string(wheel.size()) + " timers, expected " +
+                                        to_string(armed.size()));
+                }
+            }
+            for (const auto &[token, timer] : armed) {
+                if (wheel.time_left(timer.id) != timer.deadline - wheel.now()) {
+                    throw runtime_error("wrong time left for timer " + to_string(token));
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+#include "test_utils_udp.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // sendto_batch sends every payload, and recv_batch takes them in order, at most `count` per call
+        {
+            UDPSocket sender = bound_socket(), receiver = bound_socket();
+            vector<string> sent;
+            for (size_t i = 0; i < 100; i++) {
+                sent.push_back(string(i * 10, char('a' + i % 26)));
+            }
+            sender.sendto_batch(receiver.local_address(), {sent.begin(), sent.end()});
+
+            vector<UDPSocket::received_datagram> datagrams(64, {{nullptr, 0}, {}});
+            vector<string> received;
+            while (received.size() < sent.size()) {
+                const size_t n = receiver.recv_batch(datagrams, 32);
+                test_err_if(n < 1 or n > 32, "recv_batch exceeded its count");
+                for (size_t i = 0; i < n; i++) {
+                    test_err_if(datagrams[i].source_address != sender.local_address(), "wrong source address");
+                    received.push_back(datagrams[i].payload);
+                }
+            }
+            test_err_if(received != sent, "datagrams lost, reordered or corrupted");
+
+            sender.sendto_batch(receiver.local_address(), {string(2000, 'x')});
+            bool threw = false;
+            try {
+                receiver.recv_batch(datagrams, 1, true, 1000);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "oversized datagram not reported");
+            test_err_if(receiver.recv_batch(datagrams, 32, false) != 0, "recv_batch waited on an empty socket");
+        }
+
+        // the adapters write a batch (cutting super-segments) and read it back, skipping unrelated datagrams
+        {
+            TCPOverUDPSocketAdapter a{bound_socket()}, b{bound_socket()};
+            UDPSocket stranger = bound_socket();
+            a.config_mut().destination = static_cast<UDPSocket &>(b).local_address();
+            b.config_mut().destination = static_cast<UDPSocket &>(a).local_address();
+
+            vector<TCPSegment> segs{data_segment(1, 100), data_segment(101, 2500), data_segment(2601, 0)};
+            segs[1].gso_size() = 1000;
+            a.write_batch(segs);
+            stranger.sendto(static_cast<UDPSocket &>(b).local_address(), data_segment(0, 10).serialize());
+            a.write_batch(segs);
+
+            vector<TCPSegment> received;
+            while (received.size() < 10) {
+                b.read_batch(received, 64);
+            }
+            const vector<size_t> sizes{100, 1000, 1000, 500, 0};
+            for (size_t i = 0; i < received.size(); i++) {
+                test_err_if(received[i].payload().size() != sizes[i % sizes.size()] or
+                                received[i].header().dport != static_cast<UDPSocket &>(b).local_address().port(),
+                            "wrong segment " + to_string(i));
+            }
+            test_err_if(received[2].header().seqno != WrappingInt32{1101} or received[2].payload().str()[0] != 'x',
+                        "super-segment not cut in order");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+#include "test_utils_udp.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+
+//! Receive datagrams from `sock` until `size` bytes have come, cutting merged ones apart
+static vector<string> receive(UDPSocket &sock, const size_t size) {
+    vector<string> datagrams;
+    for (size_t received = 0; received < size;) {
+        const auto datagram = sock.recv();
+        const size_t piece = datagram.gro_size == 0 ? datagram.payload.size() : datagram.gro_size;
+        for (size_t offset = 0; offset < datagram.payload.size(); offset += piece) {
+            datagrams.push_back(datagram.payload.substr(offset, piece));
+        }
+        received += datagram.payload.size();
+    }
+    return datagrams;
+}
+
+int main() {
+    try {
+        // the kernel cuts a payload into datagrams of the given size, and merges them again for a socket that asks
+        {
+            UDPSocket sender = bound_socket(), plain = bound_socket(), merging = bound_socket();
+            try {
+                sender.set_gso_size(0);
+                merging.set_gro(true);
+            } catch (const unix_error &e) {
+                cerr << "UDP GSO/GRO unavailable, skipping: " << e.what() << endl;
+                return EXIT_SUCCESS;
+            }
+
+            string payload;
+            vector<string> sent;
+            for (size_t i = 0; i < 11; i++) {
+                sent.push_back(string(i < 10 ? 1000 : 300, char('a' + i)));
+                payload += sent.back();
+            }
+            sender.sendto_batch(plain.local_address(), {payload, "alone"}, {1000, 0});
+            sender.sendto_batch(merging.local_address(), {payload, "alone"}, {1000, 0});
+            sent.push_back("alone");
+
+            test_err_if(receive(plain, payload.size() + 5) != sent, "payload not cut into datagrams");
+            test_err_if(receive(merging, payload.size() + 5) != sent, "merged datagrams not cut apart");
+        }
+
+        // adapters with offload carry super-segments, runs of equal-sized segments and odd sizes alike
+        {
+            TCPOverUDPSocketAdapter a{bound_socket()}, b{bound_socket()};
+            a.config_mut().destination = static_cast<UDPSocket &>(b).local_address();
+            b.config_mut().destination = static_cast<UDPSocket &>(a).local_address();
+            a.config_mut().udp_offload = b.config_mut().udp_offload = true;
+
+            vector<TCPSegment> segs{data_segment(1, 100), data_segment(101, 100000), data_segment(100101, 500)};
+            segs[1].gso_size() = 1000;
+            for (uint32_t i = 0; i < 3; i++) {
+                segs.push_back(data_segment(100601 + i * 500, 500));
+            }
+            a.write_batch(segs);
+
+            vector<TCPSegment> received;
+            while (received.size() < 105) {
+                b.read_batch(received, 64);
+            }
+            test_err_if(received.size() != 105, "wrong number of segments");
+            uint32_t seqno = 1;
+            for (size_t i = 0; i < received.size(); i++) {
+                const size_t size = i == 0 ? 100 : i <= 100 ? 1000 : 500;
+                const uint32_t first = i == 0 ? 1 : i <= 100 ? 101 : seqno;
+                test_err_if(received[i].header().seqno != WrappingInt32{seqno} or
+                                received[i].payload().size() != size or
+                                received[i].payload().str()[0] != char('a' + first % 26),
+                            "wrong segment " + to_string(i));
+                seqno += size;
+            }
+
+            // read() hands out a merged datagram's segments one at a time, counting the rest as unread()
+            vector<TCPSegment> super{data_segment(1, 5000)};
+            super[0].gso_size() = 1000;
+            a.write_batch(super);
+            for (uint32_t i = 0; i < 5; i++) {
+                optional<TCPSegment> seg;
+                while (not seg) {
+                    seg = b.read();
+                }
+                test_err_if(seg->header().seqno != WrappingInt32{1 + i * 1000} or seg->payload().size() != 1000,
+                            "read() lost a piece");
+                test_err_if(b.unread() != 4 - i, "wrong count of unread pieces");
+            }
+
+            // read_batch() returns the pieces read() left behind, without waiting on the (empty) socket
+            a.write_batch(super);
+            optional<TCPSegment> first;
+            while (not first) {
+                first = b.read();
+            }
+            vector<TCPSegment> rest;
+            test_err_if(b.read_batch(rest, 64) != 0 or rest.size() != 4 or b.unread() != 0,
+                        "unread pieces not returned");
+            test_err_if(rest[0].header().seqno != WrappingInt32{1001}, "unread pieces out of order");
+        }
+
+        // if the kernel rejects a GSO payload, the datagrams that hadn't gone out go one by one, and only once
+        {
+            TCPOverUDPSocketAdapter a{bound_socket()}, b{bound_socket()};
+            a.config_mut().destination = static_cast<UDPSocket &>(b).local_address();
+            b.config_mut().destination = static_cast<UDPSocket &>(a).local_address();
+            a.config_mut().udp_offload = true;
+            // UDP_SEGMENT needs UDP checksums, so the kernel refuses it (EINVAL) on a socket without them
+            const int no_check = 1;
+            SystemCall("setsockopt",
+                       setsockopt(static_cast<UDPSocket &>(a).fd_num(),
+                                  SOL_SOCKET,
+                                  SO_NO_CHECK,
+                                  &no_check,
+                                  sizeof(no_check)));
+
+            vector<TCPSegment> segs{data_segment(1, 100), data_segment(101, 3000), data_segment(3101, 100)};
+            segs[1].gso_size() = 1000;
+            a.write_batch(segs);
+            a.write_batch(segs);
+
+            vector<TCPSegment> received;
+            while (received.size() < 10) {
+                b.read_batch(received, 64);
+            }
+            const vector<uint32_t> seqnos{1, 101, 1101, 2101, 3101};
+            for (size_t i = 0; i < received.size(); i++) {
+                test_err_if(received[i].header().seqno != WrappingInt32{seqnos[i % seqnos.size()]},
+                            "datagram lost or sent twice at " + to_string(i));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "test_err_if.hh"
+#include "test_utils_tcp_connection.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static TCPConfig config(const size_t capacity, const bool window_scaling) {
+    TCPConfig cfg;
+    cfg.send_capacity = capacity;
+    cfg.recv_capacity = capacity;
+    cfg.window_scaling = window_scaling;
+    return cfg;
+}
+
+int main() {
+    try {
+        // the option survives serialization, and doff governs the header's length
+        {
+            TCPHeader h;
+            h.syn = true;
+            h.wscale = 7;
+            h.doff = (TCPHeader::LENGTH + h.options_length()) / 4;
+            TCPHeader parsed;
+            NetParser p{string{h.serialize()}};
+            test_err_if(not (parsed.parse(p) == ParseResult::NoError and parsed == h),
+                        "window scale did not round-trip");
+
+            h.doff = TCPHeader::LENGTH / 4;
+            NetParser short_p{string{h.serialize()}};
+            test_err_if(parsed.parse(short_p) != ParseResult::NoError or parsed.wscale.has_value(),
+                        "option written past doff");
+        }
+
+        // other options (here MSS, SACK permitted, timestamps) don't get in the way, and shifts are capped at 14
+        {
+            TCPHeader h;
+            h.doff = (TCPHeader::LENGTH + 20) / 4;
+            string raw = h.serialize().substr(0, TCPHeader::LENGTH);
+            raw += string{"\x02\x04\x05\xb4\x04\x02\x08\x0a", 8} + string(8, '\x11') + string{"\x01\x03\x03\x0f", 4};
+            TCPHeader parsed;
+            NetParser p{move(raw)};
+            test_err_if(parsed.parse(p) != ParseResult::NoError or parsed.wscale != TCPHeader::MAX_WSCALE,
+                        "window scale not found among other options");
+            test_err_if(parsed.mss != 1460, "MSS not found among other options");
+        }
+
+        // two connections with 1 MiB buffers scale their windows by 2^5, and use all of them
+        {
+            const size_t capacity = 1 << 20;
+            TCPConnection a{config(capacity, true)}, b{config(capacity, true)};
+            a.connect();
+            const TCPSegment syn = deliver(a, b).back();
+            test_err_if(syn.header().wscale != 5 or syn.header().win != 65535, "SYN did not offer a window scale");
+            const TCPSegment syn_ack = deliver(b, a).back();
+            test_err_if(syn_ack.header().wscale != 5, "SYN-ACK did not accept the window scale");
+            const TCPSegment ack = deliver(a, b).back();
+            test_err_if(ack.header().wscale.has_value() or ack.header().win != capacity >> 5, "ACK window not scaled");
+
+            // the SYN-ACK's window is never scaled, so only the first 64 KiB go out before an ACK
+            a.write(string(500000, 'x'));
+            test_err_if(a.bytes_in_flight() != 65535, "sender did not use the SYN-ACK's window");
+            deliver(a, b);
+            deliver(b, a);
+            test_err_if(a.bytes_in_flight() != 500000 - 65535, "sender did not use the scaled window");
+            deliver(a, b);
+            const TCPSegment data_ack = deliver(b, a).back();
+            test_err_if(data_ack.header().win != (capacity - 500000) >> 5 or a.bytes_in_flight() != 0,
+                        "receiver did not accept a window's worth of data");
+        }
+
+        // a peer that doesn't offer the option keeps both directions to 16-bit windows
+        {
+            const size_t capacity = 1 << 20;
+            TCPConnection a{config(capacity, true)}, b{config(capacity, false)};
+            a.connect();
+            deliver(a, b);
+            const TCPSegment syn_ack = deliver(b, a).back();
+            test_err_if(syn_ack.header().wscale.has_value(), "SYN-ACK carried a window scale it wasn't configured for");
+            const TCPSegment ack = deliver(a, b).back();
+            test_err_if(ack.header().win != 65535, "window scaled without agreement");
+            a.write(string(500000, 'x'));
+            test_err_if(a.bytes_in_flight() != 65535, "sender exceeded the unscaled window");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}